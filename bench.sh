@@ -0,0 +1,21 @@
+#!/bin/bash
+
+name="binder_bench"
+
+args_bench=()
+
+add_range_to_args_bench() {
+    local start=$1
+    local end=$2
+    for ((i=start; i<=end; i++)); do
+        args_bench+=("$i")
+    done
+}
+
+add_range_to_args_bench 101 117
+
+for arg in "${args_bench[@]}"; do
+    echo "Benchmark $name -DBENCH_NUM=$arg..."
+    g++ -Wall -Wextra -O2 -std=c++20 $name.cpp -o bench.out -DBENCH_NUM=$arg && ./bench.out
+    echo
+done
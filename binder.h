@@ -1,308 +1,1208 @@
 #ifndef BINDER_H
 #define BINDER_H
 
-#include <list>
-#include <map>
+#include <concepts>
 #include <memory>
 #include <iterator>
+#include <ranges>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "binder_allocator.h"
+#include "binder_detail.h"
+#include "binder_flat.h"
+#include "binder_index.h"
+#include "binder_persistent.h"
+#include "binder_ranked.h"
+#include "binder_shared.h"
+#include "binder_small.h"
+#include "binder_soa.h"
+#include "binder_threading.h"
+#include "binder_unrolled.h"
 
 namespace cxx {
-    template <typename K, typename V>
-    class binder {
-        struct Note;
-        using data_list = std::list<Note>;
-        using data_iter = typename data_list::iterator;
-        using iters_map = std::map<K, typename data_list::iterator>;
-
-        struct Note {
-            typename iters_map::iterator first;
-            V second;
+    // Default storage: notes in an intrusive doubly-linked list in insertion
+    // order. The nodes are allocated and found by the key index policy
+    // (default_index_t<K> by default), one allocation per note, from the
+    // arena of the allocator policy (default_allocator by default). Unsharing
+    // copies every note.
+    struct list_storage : detail::storage_policy {
+        template <typename K, typename V, typename Policies>
+        class data {
+            using index_policy = detail::select_policy_t<detail::index_policy, default_index_t<K>, Policies>;
+            using allocator_policy = detail::select_policy_t<detail::allocator_policy, default_allocator, Policies>;
+            using arena_type = typename allocator_policy::arena;
+            using iters_map = typename index_policy::template index<K, V, typename allocator_policy::allocator_type>;
+            using node = typename iters_map::node;
+
+            // Nodes need no destructor calls, so the arena may drop them all at once.
+            static constexpr bool bulk_release = arena_type::bulk_release &&
+                std::is_trivially_destructible_v<K> && std::is_trivially_destructible_v<V>;
+
+            arena_type arena;
+            iters_map iters{arena.get()};
+            node* head = nullptr;
+            node* tail = nullptr;
+            size_t count = 0;
+
+            static auto& body(node* n) noexcept { return iters_map::body(n); }
+
+            // Links n after position, or at the front if position is null.
+            void link_after(node* position, node* n) noexcept {
+                body(n).prev = position;
+                body(n).next = position ? body(position).next : head;
+                (body(n).next ? body(body(n).next).prev : tail) = n;
+                (position ? body(position).next : head) = n;
+                ++count;
+            }
+
+            void unlink(node* n) noexcept {
+                (body(n).prev ? body(body(n).prev).next : head) = body(n).next;
+                (body(n).next ? body(body(n).next).prev : tail) = body(n).prev;
+                --count;
+            }
+
+        public:
+            using handle = node const*;
+
+            template <typename Q>
+            static constexpr bool transparent_for = index_policy::template transparent_for<K, Q>;
+
+            // Whether notes can be moved to another storage of the same type
+            // without being copied and without throwing (see adopt_after).
+            static constexpr bool nothrow_adopt = iters_map::nothrow_transfer && !arena_type::bulk_release;
+
+            data() = default;
+
+            // The index is cloned along its structure, then the copies are
+            // linked in the order of the originals.
+            data(data const& other) {
+                auto copy_of = iters.clone_from(other.iters);
+                for (node const* n = other.head; n; n = iters_map::body(n).next)
+                    link_after(tail, copy_of(n));
+            }
+
+            data(data const& other, detail::deep_copy_t) : data(other) {}
+
+            ~data() {
+                if constexpr (bulk_release)
+                    iters.forget();
+            }
+
+            size_t size() const noexcept { return count; }
+
+            handle begin() const noexcept { return head; }
+            handle last() const noexcept { return tail; }
+            handle end() const noexcept { return nullptr; }
+            handle next(handle h) const noexcept { return iters_map::body(h).next; }
+            handle prev(handle h) const noexcept { return iters_map::body(h).prev; }
+
+            template <typename Q>
+            handle find(Q const& k) const {
+                return iters.find(k);
+            }
+
+            K const& key(handle h) const noexcept { return iters_map::key_of(h); }
+
+            V const& value(handle h) const noexcept { return iters_map::body(h).value; }
+
+            V& value_for_write(handle h) noexcept { return body(const_cast<node*>(h)).value; }
+
+            template <typename KK, typename VV>
+            handle insert_front(KK&& k, VV&& v) {
+                node* n = iters.emplace(std::forward<KK>(k), std::forward<VV>(v));  // strong guarantee
+                link_after(nullptr, n);
+                return n;
+            }
+
+            template <typename KK, typename VV>
+            handle insert_after(handle position, KK&& k, VV&& v) {
+                node* n = iters.emplace(std::forward<KK>(k), std::forward<VV>(v));  // strong guarantee
+                link_after(const_cast<node*>(position), n);
+                return n;
+            }
+
+            // Inserts at the back; returns end() if k is already present.
+            template <typename KK, typename VV>
+            handle try_append(KK&& k, VV&& v) {
+                node* n = iters.try_emplace_back(std::forward<KK>(k), std::forward<VV>(v)); // strong guarantee
+                if (n)
+                    link_after(tail, n);
+                return n;
+            }
+
+            // Builds the key and the value from the elements of the tuples and
+            // inserts the note after position, or at the front if position is
+            // end(). Returns end() if the key is already present.
+            template <typename KT, typename VT>
+            handle try_emplace_after(handle position, KT&& key_args, VT&& value_args) {
+                node* n = iters.try_emplace_piecewise(std::forward<KT>(key_args),   // strong guarantee
+                                                      std::forward<VT>(value_args));
+                if (n)
+                    link_after(const_cast<node*>(position), n);
+                return n;
+            }
+
+            // Moves the note h after position, or to the front if position is
+            // end(). The node stays where it is in the index.
+            void relink_after(handle position, handle h) noexcept {
+                node* n = const_cast<node*>(h);
+                unlink(n);
+                link_after(const_cast<node*>(position), n);
+            }
+
+            void reserve(size_t n) {                                            // strong guarantee
+                iters.reserve(n);
+            }
+
+            // Moves the note h of other after position, or to the front if
+            // position is end(). Room for it must have been reserved.
+            void adopt_after(handle position, data& other, handle h) noexcept requires nothrow_adopt {
+                node* n = const_cast<node*>(h);
+                other.unlink(n);
+                iters.adopt(other.iters, n);
+                link_after(const_cast<node*>(position), n);
+            }
+
+            void erase(handle position) noexcept {
+                node* n = const_cast<node*>(position);
+                unlink(n);                                                      // no-throw
+                iters.erase(n);                                                 // no-throw
+            }
+
+            void clear() noexcept {
+                if constexpr (bulk_release) {
+                    iters.forget();
+                    arena.release();
+                } else {
+                    iters.clear();
+                }
+                head = tail = nullptr;
+                count = 0;
+            }
         };
+    };
+
+    // Result of the try_ operations of binder: key_exists if the key to
+    // insert is present, key_not_found if the key to find (or to insert
+    // after) is absent, empty if there is no note to remove.
+    enum class binder_status { ok, key_exists, key_not_found, empty };
 
-        static inline const data_list EMPTY_LIST = {};
+    template <typename K, typename V, typename... Policies>
+    class binder {
+        static_assert((detail::is_policy_v<Policies> && ...), "Unknown binder policy");
+
+        using policies = detail::policy_list<Policies...>;
+        // Only the index is picked from K by default (default_index_t); the
+        // storage is always list_storage unless named. Its values, each in
+        // its own node, never move while their notes exist, so a reference
+        // returned by read, or a value seen by an iterator, stays valid
+        // across insertions of other notes for every K and V. The
+        // contiguous storages (flat_storage, soa_storage, small_storage,
+        // unrolled_storage) move values when they grow, so they are opt-in.
+        using Storage = detail::select_policy_t<detail::storage_policy, list_storage, policies>;
+        using Data = typename Storage::template data<K, V, policies>;
+        using Threading = detail::select_policy_t<detail::threading_policy, multi_threaded, policies>;
+        using handle = typename Data::handle;
 
-        struct Data {
-            data_list data;
-            iters_map iters;
+        // The storage together with the count of binders sharing it.
+        struct shared_data : Data, detail::ref_counted<typename Threading::counter> {
+            using Data::Data;
         };
 
-        std::shared_ptr<Data> data_ptr;
-        bool was_mutable_read;
+        using data_ptr_t = detail::counted_ptr<shared_data>;
 
-        std::shared_ptr<Data> ensure_unique() {
-            if (!data_ptr)
-                data_ptr = std::make_shared<Data>();
+        static constexpr bool nothrow_iteration =
+            noexcept(std::declval<Data const&>().begin()) && noexcept(std::declval<Data const&>().last()) &&
+            noexcept(std::declval<Data const&>().next(std::declval<handle>())) &&
+            noexcept(std::declval<Data const&>().prev(std::declval<handle>()));
 
-            else if (!data_ptr.unique()) {
-                std::shared_ptr<Data> new_data_ptr = std::make_shared<Data>();
+        static constexpr bool nothrow_erase =
+            noexcept(std::declval<Data&>().erase(std::declval<handle>()));
 
-                for (const auto& item : data_ptr->data) {
-                    new_data_ptr->data.push_back({item.first, item.second});
-                    auto it = std::prev(new_data_ptr->data.end());
-                    new_data_ptr->iters[item.first->first] = it;
-                    new_data_ptr->data.back().first = new_data_ptr->iters.find(item.first->first);
-                }
+        // Whether notes move between unshared storages without being copied
+        // (list_storage and ranked_storage, see adopt_after).
+        static constexpr bool nothrow_adopt = requires { requires Data::nothrow_adopt; };
+
+        // Whether the storage finds notes by position (ranked_storage).
+        static constexpr bool positional = requires (Data const& d, handle h) {
+            d.nth(size_t());
+            d.index_of(h);
+        };
+
+        static inline const Data EMPTY_DATA = {};
 
-                std::shared_ptr<Data> res = std::move(data_ptr);
-                data_ptr = new_data_ptr;
+        data_ptr_t data_ptr;
+        bool was_mutable_read;
 
-                return res;
+        // Makes this binder the only owner of its storage, cloning the storage
+        // if it is shared. Returns the replaced storage, or null if nothing was
+        // cloned, for rollback. Only owners can raise the count, so once the
+        // acquire load in unique() reads 1 it stays 1, and the release
+        // decrements of former owners guarantee they no longer read the storage.
+        data_ptr_t ensure_unique() {                                           // strong guarantee
+            if (!data_ptr) {
+                data_ptr = data_ptr_t::make();
+                return nullptr;
             }
-            return data_ptr;
-        }
 
-    public:
-        binder() : data_ptr(std::make_shared<Data>()), was_mutable_read(false) {} // except
+            if (data_ptr.unique())
+                return nullptr;
 
-        binder(const binder<K, V>& rhs) : data_ptr(rhs.data_ptr), was_mutable_read(false) {
-            if (rhs.was_mutable_read)
-                ensure_unique();
+            data_ptr_t new_data_ptr = data_ptr_t::make(*data_ptr);
+            return std::exchange(data_ptr, std::move(new_data_ptr));
         }
 
-        binder(binder<K, V>&& rhs) noexcept : data_ptr(std::move(rhs.data_ptr)), was_mutable_read(false) {
-            rhs.data_ptr = nullptr;
+        void rollback(data_ptr_t& prev) noexcept {
+            if (prev)
+                data_ptr = std::move(prev);
         }
-        
-        ~binder() = default;
 
-        binder& operator=(binder<K, V> rhs) {
-            data_ptr = std::move(rhs.data_ptr);
-            was_mutable_read = false;
-            return *this;
+        // Types by which notes are found: K, and any type the index compares
+        // (or hashes) with K transparently, which spares building a K.
+        template <typename Q>
+        static constexpr bool lookup_key = std::same_as<Q, K> || Data::template transparent_for<Q>;
+
+        // The prev_k of insertions at the front.
+        static constexpr K const* no_key = nullptr;
+
+        // Arguments of insert_front and insert_after that may be moved or
+        // converted into the note instead of being copied.
+        template <typename KK, typename VV>
+        static constexpr bool forwarded_note = std::convertible_to<KK, K> && std::convertible_to<VV, V>;
+
+        // Forwards u, or passes it as const if T cannot be built from it.
+        template <typename T, typename U>
+        static constexpr auto&& forward_or_copy(U&& u) noexcept {
+            if constexpr (std::is_constructible_v<T, U&&>)
+                return std::forward<U>(u);
+            else
+                return std::as_const(u);
         }
 
-        void insert_front(K const& k, V const& v) {                             // except
-            if (!data_ptr)
-                data_ptr = std::make_shared<Data>();
+        // Inserts a note after the note with key prev_k, or at the front if
+        // prev_k is null.
+        template <typename Q, typename KK, typename VV>
+        binder_status insert(Q const* prev_k, KK&& k, VV&& v) {
+            if (!data_ptr) {
+                if (prev_k)
+                    return binder_status::key_not_found;  // no storage for a failed insert
+                data_ptr = data_ptr_t::make();
+            }
 
-            if (data_ptr->iters.find(k) != data_ptr->iters.end())
-                throw std::invalid_argument("Key already exists");
+            auto position = prev_k ? data_ptr->find(*prev_k) : data_ptr->end();
+
+            if (prev_k && position == data_ptr->end())
+                return binder_status::key_not_found;
+            if (data_ptr->find(k) != data_ptr->end())
+                return binder_status::key_exists;
 
             auto prev = ensure_unique();
 
             try {
-                data_ptr->data.push_front({data_ptr->iters.end(), v});          // strong guarantee
+                if (prev && prev_k)
+                    position = data_ptr->find(*prev_k);
+                if (prev_k)
+                    data_ptr->insert_after(position, std::forward<KK>(k), std::forward<VV>(v)); // strong guarantee
+                else
+                    data_ptr->insert_front(std::forward<KK>(k), std::forward<VV>(v));  // strong guarantee
             } catch (...) {
-                data_ptr = std::move(prev);
+                rollback(prev);
                 throw;
             }
+            was_mutable_read = false;
+            return binder_status::ok;
+        }
+
+        // A key of another type is converted once, not at every lookup.
+        template <typename Q, typename KK, typename VV>
+            requires (!std::same_as<std::remove_cvref_t<KK>, K>)
+        binder_status insert(Q const* prev_k, KK&& k, VV&& v) {
+            return insert(prev_k, K(std::forward<KK>(k)), std::forward<VV>(v));
+        }
+
+        // Like insert, but builds the key and the value from the elements of
+        // the tuples. The note is built before the key is checked, so a
+        // duplicate key is reported after unsharing the storage.
+        template <typename Q, typename KT, typename VT>
+        void emplace(Q const* prev_k, KT&& key_args, VT&& value_args) {
+            if (!data_ptr) {
+                if (prev_k)
+                    throw std::invalid_argument("Key already exists");
+                data_ptr = data_ptr_t::make();
+            }
+
+            if (prev_k && data_ptr->find(*prev_k) == data_ptr->end())
+                throw std::invalid_argument("Key already exists");
+
+            auto prev = ensure_unique();
+            bool inserted;
 
             try {
-                auto it = data_ptr->data.begin();                               // no-throw guarantee
-                auto [inserted_map_iter, _] = data_ptr->iters.insert({k, it});  // strong_guarantee
-                data_ptr->data.front().first = inserted_map_iter;
-                was_mutable_read = false;
+                handle position = prev_k ? data_ptr->find(*prev_k) : data_ptr->end();
+                inserted = data_ptr->try_emplace_after(position, std::forward<KT>(key_args), // strong guarantee
+                                                       std::forward<VT>(value_args)) != data_ptr->end();
             } catch (...) {
-                data_ptr->data.pop_front();                                     // no-throw guarantee
-                data_ptr = std::move(prev);
+                rollback(prev);
                 throw;
             }
+
+            if (!inserted) {
+                rollback(prev);
+                throw std::invalid_argument("Key already exists");
+            }
+            was_mutable_read = false;
         }
 
-        void insert_after(K const& prev_k, K const& k, V const& v) {            // except
+        // Inserts the notes of [first, last) in their order after prev_k, or
+        // at the front if prev_k is null, with a single checkpoint for the
+        // whole batch. A failed batch is erased from the storage, or, if the
+        // storage cannot erase without throwing, the storage is cloned up front
+        // and the original restored.
+        template <typename Q, typename It, typename S>
+        void insert_range(Q const* prev_k, It first, S last) {
+            if (prev_k && (!data_ptr || data_ptr->find(*prev_k) == data_ptr->end()))
+                throw std::invalid_argument("Key already exists");
+
+            if (first == last)
+                return;
+
             if (!data_ptr)
-                data_ptr = std::make_shared<Data>();
+                data_ptr = data_ptr_t::make();
 
-            auto map_iter = data_ptr->iters.find(prev_k);
-            
-            if (data_ptr->iters.find(k) != data_ptr->iters.end() 
-                || map_iter == data_ptr->iters.end()) {
-                    throw std::invalid_argument("Key already exists");
-            }
-            auto position = map_iter->second;
+            data_ptr_t prev;
+            if constexpr (nothrow_erase && nothrow_iteration)
+                prev = ensure_unique();
+            else
+                prev = std::exchange(data_ptr, data_ptr_t::make(*data_ptr));
 
-            bool was_unique = data_ptr.unique();
-            auto prev = ensure_unique();
+            handle position = prev_k ? data_ptr->find(*prev_k) : data_ptr->end();
+            size_t inserted = 0;
+
+            try {
+                for (; first != last; ++first) {
+                    auto&& note = *first;
+                    auto&& k = forward_or_copy<K>(std::get<0>(std::forward<decltype(note)>(note)));
+                    auto&& v = forward_or_copy<V>(std::get<1>(std::forward<decltype(note)>(note)));
+                    if (data_ptr->find(k) != data_ptr->end())
+                        throw std::invalid_argument("Key already exists");
 
-            if (!was_unique) {
-                try {
-                    map_iter = data_ptr->iters.find(prev_k);
-                    position = map_iter->second;
-                } catch (...) {
-                    data_ptr = std::move(prev);
-                    throw;
+                    position = position == data_ptr->end()
+                        ? data_ptr->insert_front(std::forward<decltype(k)>(k), std::forward<decltype(v)>(v))
+                        : data_ptr->insert_after(position, std::forward<decltype(k)>(k),
+                                                 std::forward<decltype(v)>(v));
+                    ++inserted;
                 }
+            } catch (...) {
+                if constexpr (nothrow_erase && nothrow_iteration) {
+                    // Handles taken before an insertion may be invalid after
+                    // it, so the batch is erased from its last note back.
+                    if (!prev) {
+                        for (; inserted > 0; --inserted) {                      // no-throw
+                            handle before = data_ptr->prev(position);
+                            data_ptr->erase(position);
+                            position = before;
+                        }
+                    }
+                }
+                rollback(prev);
+                throw;
             }
+            was_mutable_read = false;
+        }
+
+        binder_status erase_front() {
+            if (size() == 0)
+                return binder_status::empty;
+
+            auto prev = ensure_unique();
 
             try {
-                ++position;                                                     // iterator points to the element after prev_k
-                data_ptr->data.insert(position, {data_ptr->iters.end(), v});    // strong guarantee
-                --position;                                                     // iterator points to inserted element
+                data_ptr->erase(data_ptr->begin());                             // strong guarantee
             } catch (...) {
-                data_ptr = std::move(prev);
+                rollback(prev);
                 throw;
             }
+            was_mutable_read = false;
+            return binder_status::ok;
+        }
+
+        template <typename Q>
+        binder_status erase(Q const& k) {
+            if (!data_ptr)
+                return binder_status::key_not_found;
+
+            auto position = data_ptr->find(k);
+            if (position == data_ptr->end())
+                return binder_status::key_not_found;
+
+            auto prev = ensure_unique();
 
             try {
-                auto [inserted_map_iter, _] = data_ptr->iters.insert({k, position});   // strong guarantee
-                position->first = inserted_map_iter;
-                was_mutable_read = false;
+                if (prev)
+                    position = data_ptr->find(k);
+                data_ptr->erase(position);                                      // strong guarantee
             } catch (...) {
-                data_ptr->data.erase(position);                                 // no-throw
-                data_ptr = std::move(prev);
+                rollback(prev);
                 throw;
             }
+            was_mutable_read = false;
+            return binder_status::ok;
         }
 
-        void remove() { // except
+        // Moves the note with key k after the note with key prev_k, to the
+        // back if back is set, or else to the front if prev_k is null.
+        template <typename P, typename Q>
+        void relink(P const* prev_k, bool back, Q const& k) {
             if (!data_ptr)
-                data_ptr = std::make_shared<Data>();
+                throw std::invalid_argument("Key does not exist");
 
-            if (size() == 0)
-                throw std::invalid_argument("Binder is empty");
+            auto locate = [&] {
+                handle position = back ? data_ptr->last() : prev_k ? data_ptr->find(*prev_k) : data_ptr->end();
+                return std::pair(position, data_ptr->find(k));
+            };
 
-            K k = data_ptr->data.front().first->first;
+            auto [position, n] = locate();
+            if (n == data_ptr->end() || (prev_k && position == data_ptr->end()))
+                throw std::invalid_argument("Key does not exist");
+            if (n == position || (position == data_ptr->end() ? data_ptr->begin() : data_ptr->next(position)) == n)
+                return;
 
             auto prev = ensure_unique();
+
             try {
-                auto it = data_ptr->iters.find(k);                              // strong guarantee
-                data_ptr->iters.erase(it);                                      // no-throw
-                data_ptr->data.pop_front();                                     // no-throw
-                was_mutable_read = false;
+                if (prev)
+                    std::tie(position, n) = locate();
+                data_ptr->relink_after(position, n);                            // strong guarantee
             } catch (...) {
-                data_ptr = std::move(prev);
+                rollback(prev);
                 throw;
             }
+            was_mutable_read = false;
         }
 
-        void remove(K const& k) {                                               // except
+        // The notes of a storage from current on, as (key, value) pairs for
+        // insert_range.
+        struct note_iterator {
+            using difference_type = std::ptrdiff_t;
+            using value_type = std::pair<K const&, V const&>;
+
+            Data const* data = nullptr;
+            handle current{};
+
+            value_type operator*() const noexcept { return {data->key(current), data->value(current)}; }
+
+            note_iterator& operator++() noexcept(nothrow_iteration) {
+                current = data->next(current);
+                return *this;
+            }
+
+            bool operator==(note_iterator const& other) const noexcept { return current == other.current; }
+        };
+
+        // Moves the notes of other after the note with key prev_k, to the
+        // back if back is set, or else to the front if prev_k is null. If
+        // neither storage is shared and notes can be adopted, the nodes of
+        // the smaller storage are relinked into the larger one, which becomes
+        // the storage of this binder. Otherwise the notes of other are copied.
+        template <typename P>
+        void splice(P const* prev_k, bool back, binder& other) {
+            if (!data_ptr) {
+                if (prev_k)
+                    throw std::invalid_argument("Key does not exist");
+                if (other.size() == 0)
+                    return;
+                data_ptr = data_ptr_t::make();
+            }
+
+            handle position = back ? data_ptr->last() : prev_k ? data_ptr->find(*prev_k) : data_ptr->end();
+            if (prev_k && position == data_ptr->end())
+                throw std::invalid_argument("Key does not exist");
+            if (other.size() == 0)
+                return;
+
+            bool smaller = size() <= other.size();
+            Data const& small = smaller ? *data_ptr : *other.data_ptr;
+            Data const& large = smaller ? *other.data_ptr : *data_ptr;
+            for (handle h = small.begin(); h != small.end(); h = small.next(h))
+                if (large.find(small.key(h)) != large.end())
+                    throw std::invalid_argument("Key already exists");
+
+            if constexpr (nothrow_adopt) {
+                if (data_ptr.unique() && other.data_ptr.unique()) {
+                    Data& to = *data_ptr;
+                    Data& from = *other.data_ptr;
+                    if (smaller) {
+                        from.reserve(to.size() + from.size());                  // strong guarantee
+                        for (handle h = position; h != to.end();) {             // no-throw from here
+                            handle p = to.prev(h);
+                            from.adopt_after(from.end(), to, h);
+                            h = p;
+                        }
+                        while (to.size() > 0)
+                            from.adopt_after(from.last(), to, to.begin());
+                        std::swap(data_ptr, other.data_ptr);
+                    } else {
+                        to.reserve(to.size() + from.size());                    // strong guarantee
+                        while (from.size() > 0) {                               // no-throw from here
+                            handle h = from.begin();
+                            to.adopt_after(position, from, h);
+                            position = h;
+                        }
+                    }
+                    other.clear();
+                    was_mutable_read = false;
+                    return;
+                }
+            }
+
+            note_iterator first{other.data_ptr.get(), other.data_ptr->begin()};
+            note_iterator last{other.data_ptr.get(), other.data_ptr->end()};
+            if (back && position != data_ptr->end())
+                insert_range(&data_ptr->key(position), first, last);            // strong guarantee
+            else
+                insert_range(prev_k, first, last);                              // strong guarantee
+            other.clear();
+        }
+
+        // Moves the notes after the note with key k to the returned binder.
+        // In an unshared storage whose notes can be adopted, the nodes on the
+        // shorter side of k are relinked into a new storage; otherwise the
+        // notes after k are copied and then erased.
+        template <typename Q>
+        binder split(Q const& k) {
             if (!data_ptr)
-                data_ptr = std::make_shared<Data>();
+                throw std::invalid_argument("Key does not exist");
 
-            auto map_iter = data_ptr->iters.find(k);
+            handle position = data_ptr->find(k);
+            if (position == data_ptr->end())
+                throw std::invalid_argument("Key does not exist");
 
-            if (map_iter == data_ptr->iters.end())
-                throw std::invalid_argument("Binder does not contain specified key");
+            binder tail;
+            if (data_ptr->next(position) == data_ptr->end())
+                return tail;
 
-            bool was_unique = data_ptr.unique();
-            auto prev = ensure_unique();
+            if constexpr (nothrow_adopt) {
+                if (data_ptr.unique()) {
+                    tail.data_ptr = data_ptr_t::make();
+                    Data& from = *data_ptr;
+                    Data& to = *tail.data_ptr;
+
+                    // Walks both sides of k at once until the shorter one ends.
+                    handle after = from.next(position);
+                    handle before = position;
+                    size_t shorter = 0;
+                    for (; after != from.end() && before != from.end(); ++shorter) {
+                        after = from.next(after);
+                        before = from.prev(before);
+                    }
 
-            if (!was_unique) {
-                try {
-                    map_iter = data_ptr->iters.find(k);
-                } catch (...) {
-                    data_ptr = std::move(prev);
-                    throw;
+                    to.reserve(shorter);                                        // strong guarantee
+                    if (after == from.end()) {                                  // no-throw from here
+                        while (from.next(position) != from.end())
+                            to.adopt_after(to.last(), from, from.next(position));
+                    } else {
+                        handle h;
+                        do {
+                            h = from.begin();
+                            to.adopt_after(to.last(), from, h);
+                        } while (h != position);
+                        std::swap(data_ptr, tail.data_ptr);
+                    }
+                    was_mutable_read = false;
+                    return tail;
                 }
             }
-            
-            auto position = map_iter->second;
 
-            data_ptr->iters.erase(map_iter);                                    // no-throw
-            data_ptr->data.erase(position);                                     // no-throw
+            tail.insert_range(no_key, note_iterator{data_ptr.get(), data_ptr->next(position)},
+                              note_iterator{data_ptr.get(), data_ptr->end()});
+
+            data_ptr_t prev;
+            if constexpr (nothrow_erase && nothrow_iteration)
+                prev = ensure_unique();
+            else
+                prev = std::exchange(data_ptr, data_ptr_t::make(*data_ptr));
+
+            try {
+                for (size_t n = tail.size(); n > 0; --n)
+                    data_ptr->erase(data_ptr->last());                          // strong guarantee
+            } catch (...) {
+                rollback(prev);
+                throw;
+            }
+            was_mutable_read = false;
+            return tail;
+        }
+
+    public:
+        // An empty binder owns no storage; it is allocated by the first write.
+        binder() noexcept : was_mutable_read(false) {}
+
+        // Builds a binder with the notes of [first, last) in their order. With
+        // an ordered index this is O(n) if the keys come sorted.
+        template <std::input_iterator It, std::sentinel_for<It> S>
+        binder(It first, S last) : binder() {                                   // except
+            if (first != last)
+                data_ptr = data_ptr_t::make();
+            for (; first != last; ++first) {
+                auto&& note = *first;
+                auto&& k = forward_or_copy<K>(std::get<0>(std::forward<decltype(note)>(note)));
+                auto&& v = forward_or_copy<V>(std::get<1>(std::forward<decltype(note)>(note)));
+                if (data_ptr->try_append(std::forward<decltype(k)>(k), std::forward<decltype(v)>(v)) ==
+                    data_ptr->end())
+                    throw std::invalid_argument("Key already exists");
+            }
+        }
+
+#ifdef __cpp_lib_containers_ranges
+        template <std::ranges::input_range R>
+        binder(std::from_range_t, R&& r)                                        // except
+            : binder(std::ranges::begin(r), std::ranges::end(r)) {}
+#endif
+
+        binder(const binder& rhs) : data_ptr(rhs.data_ptr), was_mutable_read(false) {
+            if (rhs.was_mutable_read && rhs.data_ptr)
+                data_ptr = data_ptr_t::make(*rhs.data_ptr, detail::deep_copy);
+        }
+
+        binder(binder&& rhs) noexcept : data_ptr(std::move(rhs.data_ptr)), was_mutable_read(false) {
+            rhs.data_ptr = nullptr;
+            rhs.was_mutable_read = false;
+        }
+
+        ~binder() = default;
+
+        binder& operator=(binder rhs) {
+            data_ptr = std::move(rhs.data_ptr);
             was_mutable_read = false;
+            return *this;
+        }
+
+        void insert_front(K const& k, V const& v) {                             // except
+            if (insert(no_key, k, v) != binder_status::ok)
+                throw std::invalid_argument("Key already exists");
+        }
+
+        // Moves rvalue arguments into the note. If an exception is thrown the
+        // binder is unchanged, but the arguments may have been moved from.
+        template <typename KK, typename VV>
+            requires forwarded_note<KK, VV>
+        void insert_front(KK&& k, VV&& v) {                                     // except
+            if (insert(no_key, std::forward<KK>(k), std::forward<VV>(v)) != binder_status::ok)
+                throw std::invalid_argument("Key already exists");
+        }
+
+        void insert_after(K const& prev_k, K const& k, V const& v) {            // except
+            if (insert(&prev_k, k, v) != binder_status::ok)
+                throw std::invalid_argument("Key already exists");
+        }
+
+        template <typename KK, typename VV>
+            requires forwarded_note<KK, VV>
+        void insert_after(K const& prev_k, KK&& k, VV&& v) {                    // except
+            if (insert(&prev_k, std::forward<KK>(k), std::forward<VV>(v)) != binder_status::ok)
+                throw std::invalid_argument("Key already exists");
+        }
+
+        // Overloads taking a key of another type Q, for lookup_key<Q> types
+        // (e.g. std::string_view for std::string keys with an ordered_index),
+        // find notes without building a K.
+        template <typename Q, typename KK, typename VV>
+            requires lookup_key<Q> && forwarded_note<KK, VV>
+        void insert_after(Q const& prev_k, KK&& k, VV&& v) {                    // except
+            if (insert(&prev_k, std::forward<KK>(k), std::forward<VV>(v)) != binder_status::ok)
+                throw std::invalid_argument("Key already exists");
+        }
+
+        // The try_ operations report a missing or duplicate key through the
+        // returned status instead of an exception, and leave the binder
+        // unchanged then. Other failures still throw.
+        binder_status try_insert_front(K const& k, V const& v) {                // except
+            return insert(no_key, k, v);
+        }
+
+        template <typename KK, typename VV>
+            requires forwarded_note<KK, VV>
+        binder_status try_insert_front(KK&& k, VV&& v) {                        // except
+            return insert(no_key, std::forward<KK>(k), std::forward<VV>(v));
+        }
+
+        binder_status try_insert_after(K const& prev_k, K const& k, V const& v) { // except
+            return insert(&prev_k, k, v);
+        }
+
+        template <typename Q, typename KK, typename VV>
+            requires lookup_key<Q> && forwarded_note<KK, VV>
+        binder_status try_insert_after(Q const& prev_k, KK&& k, VV&& v) {       // except
+            return insert(&prev_k, std::forward<KK>(k), std::forward<VV>(v));
+        }
+
+        // Builds the key and the value in place, like the piecewise
+        // constructor of std::pair.
+        template <typename... KArgs, typename... VArgs>
+        void emplace_front(std::piecewise_construct_t, std::tuple<KArgs...> key_args, // except
+                           std::tuple<VArgs...> value_args) {
+            emplace(no_key, std::move(key_args), std::move(value_args));
+        }
+
+        template <typename... KArgs, typename... VArgs>
+        void emplace_after(K const& prev_k, std::piecewise_construct_t,         // except
+                           std::tuple<KArgs...> key_args, std::tuple<VArgs...> value_args) {
+            emplace(&prev_k, std::move(key_args), std::move(value_args));
+        }
+
+        template <typename Q, typename... KArgs, typename... VArgs>
+            requires lookup_key<Q>
+        void emplace_after(Q const& prev_k, std::piecewise_construct_t,         // except
+                           std::tuple<KArgs...> key_args, std::tuple<VArgs...> value_args) {
+            emplace(&prev_k, std::move(key_args), std::move(value_args));
+        }
+
+        template <std::input_iterator It, std::sentinel_for<It> S>
+        void insert_range_front(It first, S last) {                             // except
+            insert_range(no_key, std::move(first), std::move(last));
+        }
+
+        template <std::input_iterator It, std::sentinel_for<It> S>
+        void insert_range_after(K const& prev_k, It first, S last) {            // except
+            insert_range(&prev_k, std::move(first), std::move(last));
+        }
+
+        template <typename Q, std::input_iterator It, std::sentinel_for<It> S>
+            requires lookup_key<Q>
+        void insert_range_after(Q const& prev_k, It first, S last) {            // except
+            insert_range(&prev_k, std::move(first), std::move(last));
+        }
+
+        // The move_ operations relink an existing note in the order of the
+        // notes. The note keeps its place in the key index and is not copied.
+        void move_front(K const& k) {                                           // except
+            relink(no_key, false, k);
+        }
+
+        template <typename Q>
+            requires lookup_key<Q>
+        void move_front(Q const& k) {                                           // except
+            relink(no_key, false, k);
+        }
+
+        void move_back(K const& k) {                                            // except
+            relink(no_key, true, k);
+        }
+
+        template <typename Q>
+            requires lookup_key<Q>
+        void move_back(Q const& k) {                                            // except
+            relink(no_key, true, k);
+        }
+
+        void move_after(K const& prev_k, K const& k) {                          // except
+            relink(&prev_k, false, k);
+        }
+
+        template <typename P, typename Q>
+            requires lookup_key<P> && lookup_key<Q>
+        void move_after(P const& prev_k, Q const& k) {                          // except
+            relink(&prev_k, false, k);
+        }
+
+        // The splice_ operations move all notes of other, in their order, into
+        // this binder and leave other empty. A key present in both binders is
+        // detected before anything changes. If neither binder shares its
+        // storage, no note is copied and the cost is O(min(n, m)) adoptions.
+        void splice_front(binder&& other) {                                     // except
+            splice(no_key, false, other);
+        }
+
+        void splice_back(binder&& other) {                                      // except
+            splice(no_key, true, other);
+        }
+
+        void splice_after(K const& prev_k, binder&& other) {                    // except
+            splice(&prev_k, false, other);
+        }
+
+        template <typename Q>
+            requires lookup_key<Q>
+        void splice_after(Q const& prev_k, binder&& other) {                    // except
+            splice(&prev_k, false, other);
+        }
+
+        // Moves the notes after the note with key k to the returned binder.
+        binder split_after(K const& k) {                                        // except
+            return split(k);
+        }
+
+        template <typename Q>
+            requires lookup_key<Q>
+        binder split_after(Q const& k) {                                        // except
+            return split(k);
+        }
+
+        void remove() {                                                         // except
+            if (erase_front() != binder_status::ok)
+                throw std::invalid_argument("Binder is empty");
+        }
+
+        void remove(K const& k) {                                               // except
+            remove<K>(k);
+        }
+
+        template <typename Q>
+            requires lookup_key<Q>
+        void remove(Q const& k) {                                               // except
+            if (erase(k) != binder_status::ok)
+                throw std::invalid_argument("Binder does not contain specified key");
+        }
+
+        binder_status try_remove() {                                            // except
+            return erase_front();
+        }
+
+        binder_status try_remove(K const& k) {                                  // except
+            return erase(k);
+        }
+
+        template <typename Q>
+            requires lookup_key<Q>
+        binder_status try_remove(Q const& k) {                                  // except
+            return erase(k);
         }
 
         V& read(K const& k) {                                                   // except
-            if (!data_ptr)
-                data_ptr = std::make_shared<Data>();
+            return read<K>(k);
+        }
+
+        template <typename Q>
+            requires lookup_key<Q>
+        V& read(Q const& k) {                                                   // except
+            V* value = find(k);
+            if (!value)
+                throw std::invalid_argument("Key does not exist");
+            return *value;
+        }
 
-            auto it = data_ptr->iters.find(k);
-            if (it == data_ptr->iters.end())
+        V const& read(K const& k) const {                                       // except
+            return read<K>(k);
+        }
+
+        template <typename Q>
+            requires lookup_key<Q>
+        V const& read(Q const& k) const {                                       // except
+            V const* value = find(k);
+            if (!value)
                 throw std::invalid_argument("Key does not exist");
+            return *value;
+        }
+
+        // Like read, but returns null if k is absent.
+        V* find(K const& k) {                                                   // strong guarantee
+            return find<K>(k);
+        }
+
+        template <typename Q>
+            requires lookup_key<Q>
+        V* find(Q const& k) {                                                   // strong guarantee
+            if (!data_ptr)
+                return nullptr;
+
+            auto position = data_ptr->find(k);
+            if (position == data_ptr->end())
+                return nullptr;
 
-            bool was_unique = data_ptr.unique();
             auto prev = ensure_unique();
 
-            was_mutable_read = true;
-            
-            if (was_unique) {
-                return it->second->second;
-            } else {
-                try {
-                    auto it = data_ptr->iters.find(k);
-                    return it->second->second;
-                } catch (...) {
-                    data_ptr = std::move(prev);
-                    throw;
-                }
+            try {
+                if (prev)
+                    position = data_ptr->find(k);
+                V& value = data_ptr->value_for_write(position);                 // strong guarantee
+                was_mutable_read = true;
+                return &value;
+            } catch (...) {
+                rollback(prev);
+                throw;
             }
         }
 
-        V const& read(K const& k) const {                                       // except
+        V const* find(K const& k) const {                                       // strong guarantee
+            return find<K>(k);
+        }
+
+        template <typename Q>
+            requires lookup_key<Q>
+        V const* find(Q const& k) const {                                       // strong guarantee
+            if (!data_ptr)
+                return nullptr;
+
+            auto position = data_ptr->find(k);
+            if (position == data_ptr->end())
+                return nullptr;
+
+            return &data_ptr->value(position);
+        }
+
+        bool contains(K const& k) const {                                       // strong guarantee
+            return find(k) != nullptr;
+        }
+
+        template <typename Q>
+            requires lookup_key<Q>
+        bool contains(Q const& k) const {                                       // strong guarantee
+            return find(k) != nullptr;
+        }
+
+        // Positional access, in O(log n) for storages that keep the rank of
+        // notes (ranked_storage). Positions count notes from 0 in their order.
+        V& nth(size_t i) requires positional {                                  // except
+            if (i >= size())
+                throw std::invalid_argument("Position out of range");
+
+            auto prev = ensure_unique();
+
+            try {
+                V& value = data_ptr->value_for_write(data_ptr->nth(i));         // strong guarantee
+                was_mutable_read = true;
+                return value;
+            } catch (...) {
+                rollback(prev);
+                throw;
+            }
+        }
+
+        V const& nth(size_t i) const requires positional {                      // except
+            if (i >= size())
+                throw std::invalid_argument("Position out of range");
+
+            return data_ptr->value(data_ptr->nth(i));
+        }
+
+        size_t index_of(K const& k) const requires positional {                 // except
+            return index_of<K>(k);
+        }
+
+        template <typename Q>
+            requires positional && lookup_key<Q>
+        size_t index_of(Q const& k) const {                                     // except
             if (!data_ptr)
                 throw std::invalid_argument("Key does not exist");
 
-            auto it = data_ptr->iters.find(k);
-            if (it == data_ptr->iters.end())
+            auto position = data_ptr->find(k);
+            if (position == data_ptr->end())
                 throw std::invalid_argument("Key does not exist");
 
-            return const_cast<V&>(it->second->second);
+            return data_ptr->index_of(position);
+        }
+
+        // Inserts a note at position i (i == size() appends it).
+        void insert_at(size_t i, K const& k, V const& v) requires positional {  // except
+            insert_at<K const&, V const&>(i, k, v);
+        }
+
+        template <typename KK, typename VV>
+            requires positional && forwarded_note<KK, VV>
+        void insert_at(size_t i, KK&& k, VV&& v) {                              // except
+            if (i > size())
+                throw std::invalid_argument("Position out of range");
+
+            // The key of the note before i stays valid while insert runs: a
+            // cloned storage is kept for rollback until insert returns.
+            binder_status status = i == 0
+                ? insert(no_key, std::forward<KK>(k), std::forward<VV>(v))
+                : insert(&data_ptr->key(data_ptr->nth(i - 1)), std::forward<KK>(k), std::forward<VV>(v));
+            if (status != binder_status::ok)
+                throw std::invalid_argument("Key already exists");
         }
 
         size_t size() const noexcept {
             if (!data_ptr)
                 return 0;
 
-            return data_ptr->data.size();
+            return data_ptr->size();
         }
 
         void clear() noexcept {
             was_mutable_read = false;
             if (data_ptr && data_ptr.unique()) {
-                data_ptr->data.clear();
-                data_ptr->iters.clear();
+                data_ptr->clear();
             } else {
                 data_ptr = nullptr;
             }
         }
 
-        class const_iterator {
-            typename data_list::const_iterator current;
+        // Iterates over the notes in their order, or in reverse order if
+        // Reverse. Stepping back from the end reaches the last note (the
+        // first one for a reverse iterator).
+        template <bool Reverse>
+        class basic_const_iterator {
+            const Data* data = nullptr;
+            handle current{};
 
         public:
             using difference_type = std::ptrdiff_t;
             using value_type = V;
             using pointer = const V*;
             using reference = const V&;
-            using itarator_category = std::forward_iterator_tag;
+            using iterator_category = std::bidirectional_iterator_tag;
+
+            basic_const_iterator() = default;
 
-            const_iterator() = default;
+            basic_const_iterator(const basic_const_iterator& it) : data(it.data), current(it.current) {}
 
-            const_iterator(const const_iterator& it) : current(it.current) {}
+            basic_const_iterator(const Data* data, handle it)
+                : data(data), current(it) {}
 
-            explicit const_iterator(typename data_list::const_iterator it)
-                : current(it) {}
+            ~basic_const_iterator() = default;
 
-            ~const_iterator() = default;
+            const V& operator*() const noexcept { return data->value(current); }
+            const V* operator->() const noexcept { return &(data->value(current)); }
 
-            const V& operator*() const noexcept { return current->second; }
-            const V* operator->() const noexcept { return &(current->second); }
+            const K& key() const noexcept { return data->key(current); }
 
-            const_iterator& operator++() noexcept {
-                ++current;
+            basic_const_iterator& operator++() noexcept(nothrow_iteration) {
+                if constexpr (Reverse)
+                    current = data->prev(current);
+                else
+                    current = data->next(current);
                 return *this;
             }
 
-            const_iterator operator++(int) noexcept {
-                const_iterator tmp = *this;
+            basic_const_iterator operator++(int) noexcept(nothrow_iteration) {
+                basic_const_iterator tmp = *this;
                 ++(*this);
                 return tmp;
             }
 
-            const_iterator& operator=(const_iterator const& rhs) {
+            basic_const_iterator& operator--() noexcept(nothrow_iteration) {
+                if constexpr (Reverse)
+                    current = current == data->end() ? data->begin() : data->next(current);
+                else
+                    current = current == data->end() ? data->last() : data->prev(current);
+                return *this;
+            }
+
+            basic_const_iterator operator--(int) noexcept(nothrow_iteration) {
+                basic_const_iterator tmp = *this;
+                --(*this);
+                return tmp;
+            }
+
+            basic_const_iterator& operator=(basic_const_iterator const& rhs) {
+                data = rhs.data;
                 current = rhs.current;
+                return *this;
             }
 
-            bool operator==(const const_iterator& other) const noexcept {
+            bool operator==(const basic_const_iterator& other) const noexcept {
                 return current == other.current;
             }
 
-            bool operator!=(const const_iterator& other) const {
+            bool operator!=(const basic_const_iterator& other) const {
                 return !(*this == other);
             }
         };
 
-        const_iterator cbegin() const noexcept { 
+        using const_iterator = basic_const_iterator<false>;
+        using const_reverse_iterator = basic_const_iterator<true>;
+
+        const_iterator cbegin() const noexcept(nothrow_iteration) {
+            if (!data_ptr)
+                return const_iterator(&EMPTY_DATA, EMPTY_DATA.end());
+            return const_iterator(data_ptr.get(), data_ptr->begin());
+        }
+
+        const_iterator cend() const noexcept {
             if (!data_ptr)
-                return const_iterator(EMPTY_LIST.cbegin());
-            return const_iterator(data_ptr->data.cbegin()); 
+                return const_iterator(&EMPTY_DATA, EMPTY_DATA.end());
+            return const_iterator(data_ptr.get(), data_ptr->end());
         }
 
-        const_iterator cend() const noexcept { 
+        const_iterator begin() const noexcept(nothrow_iteration) { return cbegin(); }
+
+        const_iterator end() const noexcept { return cend(); }
+
+        const_reverse_iterator crbegin() const noexcept(nothrow_iteration) {
+            if (!data_ptr)
+                return const_reverse_iterator(&EMPTY_DATA, EMPTY_DATA.end());
+            return const_reverse_iterator(data_ptr.get(), data_ptr->last());
+        }
+
+        const_reverse_iterator crend() const noexcept {
             if (!data_ptr)
-                return const_iterator(EMPTY_LIST.cbegin());
-            return const_iterator(data_ptr->data.cend()); 
+                return const_reverse_iterator(&EMPTY_DATA, EMPTY_DATA.end());
+            return const_reverse_iterator(data_ptr.get(), data_ptr->end());
+        }
+
+        // Iterator to the note at position i, or cend() if i >= size().
+        const_iterator cnth(size_t i) const noexcept requires positional {
+            if (i >= size())
+                return cend();
+            return const_iterator(data_ptr.get(), data_ptr->nth(i));
+        }
+
+        // Read-only view of the binder as it was when the snapshot was taken.
+        // It shares the storage, so the binder copies it on its next write,
+        // and the version is freed when its last owner lets it go. With the
+        // multi_threaded policy (the default) a snapshot can be read on any
+        // thread while the binder is being modified; with single_threaded the
+        // snapshot and the binder must stay on one thread.
+        class snapshot_type {
+            friend class binder;
+
+            binder b;
+
+            explicit snapshot_type(binder const& b) : b(b) {}
+
+        public:
+            snapshot_type() = default;
+
+            V const& read(K const& k) const { return b.read(k); }               // except
+
+            template <typename Q>
+                requires lookup_key<Q>
+            V const& read(Q const& k) const { return b.read(k); }               // except
+
+            V const* find(K const& k) const { return b.find(k); }               // strong guarantee
+
+            template <typename Q>
+                requires lookup_key<Q>
+            V const* find(Q const& k) const { return b.find(k); }               // strong guarantee
+
+            bool contains(K const& k) const { return b.contains(k); }           // strong guarantee
+
+            template <typename Q>
+                requires lookup_key<Q>
+            bool contains(Q const& k) const { return b.contains(k); }           // strong guarantee
+
+            size_t size() const noexcept { return b.size(); }
+
+            const_iterator cbegin() const noexcept(nothrow_iteration) { return b.cbegin(); }
+
+            const_iterator cend() const noexcept { return b.cend(); }
+
+            const_iterator begin() const noexcept(nothrow_iteration) { return b.cbegin(); }
+
+            const_iterator end() const noexcept { return b.cend(); }
+
+            const_reverse_iterator crbegin() const noexcept(nothrow_iteration) { return b.crbegin(); }
+
+            const_reverse_iterator crend() const noexcept { return b.crend(); }
+
+            V const& nth(size_t i) const requires positional { return b.nth(i); } // except
+
+            size_t index_of(K const& k) const requires positional { return b.index_of(k); } // except
+
+            template <typename Q>
+                requires positional && lookup_key<Q>
+            size_t index_of(Q const& k) const { return b.index_of(k); }         // except
+
+            const_iterator cnth(size_t i) const noexcept requires positional { return b.cnth(i); }
+        };
+
+        // O(1), unless a reference returned by read may still be written through.
+        snapshot_type snapshot() const {                                        // except
+            return snapshot_type(*this);
         }
     };
 }
@@ -0,0 +1,189 @@
+#ifndef BINDER_ALLOCATOR_H
+#define BINDER_ALLOCATOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+#include "binder_detail.h"
+
+namespace cxx {
+    namespace detail {
+        // Single-threaded slab pool. Blocks of up to classes * granularity
+        // bytes are carved from chunks of growing size and kept on per-size
+        // free lists once deallocated; larger blocks are taken from the
+        // upstream one by one. release() hands everything back to the upstream.
+        class node_pool : public std::pmr::memory_resource {
+            static constexpr size_t granularity = alignof(std::max_align_t);
+            static constexpr size_t classes = 16;
+            static constexpr size_t first_chunk = 1024;
+            static constexpr size_t max_chunk = 64 * 1024;
+
+            struct free_block {
+                free_block* next;
+            };
+
+            // Header placed right before the memory of every upstream allocation.
+            struct chunk {
+                chunk* prev;
+                chunk* next;
+                size_t bytes;
+                size_t alignment;
+            };
+
+            std::pmr::memory_resource* upstream;
+            chunk* chunks = nullptr;
+            free_block* free_lists[classes] = {};
+            std::byte* cursor = nullptr;
+            std::byte* limit = nullptr;
+            size_t next_chunk = first_chunk;
+
+            static size_t header_size(size_t alignment) noexcept {
+                return (sizeof(chunk) + alignment - 1) / alignment * alignment;
+            }
+
+            static bool pooled(size_t bytes, size_t alignment) noexcept {
+                return alignment <= granularity && bytes <= classes * granularity;
+            }
+
+            static size_t class_of(size_t bytes) noexcept {
+                return bytes == 0 ? 0 : (bytes - 1) / granularity;
+            }
+
+            std::byte* acquire(size_t bytes, size_t alignment) {                // strong guarantee
+                alignment = std::max(alignment, granularity);
+                size_t header = header_size(alignment);
+                auto* raw = static_cast<std::byte*>(upstream->allocate(header + bytes, alignment));
+
+                auto* c = ::new (static_cast<void*>(raw + header - sizeof(chunk)))
+                    chunk{nullptr, chunks, bytes, alignment};
+                if (chunks)
+                    chunks->prev = c;
+                chunks = c;
+                return raw + header;
+            }
+
+            void give_back(chunk* c) noexcept {
+                size_t header = header_size(c->alignment);
+                upstream->deallocate(reinterpret_cast<std::byte*>(c + 1) - header,
+                                     header + c->bytes, c->alignment);
+            }
+
+        protected:
+            void* do_allocate(size_t bytes, size_t alignment) override {        // strong guarantee
+                if (!pooled(bytes, alignment))
+                    return acquire(bytes, alignment);
+
+                size_t c = class_of(bytes);
+                if (free_block* block = free_lists[c]) {
+                    free_lists[c] = block->next;
+                    return block;
+                }
+
+                size_t size = (c + 1) * granularity;
+                if (static_cast<size_t>(limit - cursor) < size) {
+                    cursor = acquire(next_chunk, granularity);
+                    limit = cursor + next_chunk;
+                    next_chunk = std::min(next_chunk * 2, max_chunk);
+                }
+                void* p = cursor;
+                cursor += size;
+                return p;
+            }
+
+            void do_deallocate(void* p, size_t bytes, size_t alignment) noexcept override {
+                if (pooled(bytes, alignment)) {
+                    size_t c = class_of(bytes);
+                    free_lists[c] = ::new (p) free_block{free_lists[c]};
+                    return;
+                }
+
+                auto* c = reinterpret_cast<chunk*>(static_cast<std::byte*>(p) - sizeof(chunk));
+                (c->prev ? c->prev->next : chunks) = c->next;
+                if (c->next)
+                    c->next->prev = c->prev;
+                give_back(c);
+            }
+
+            bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override {
+                return this == &other;
+            }
+
+        public:
+            explicit node_pool(std::pmr::memory_resource* upstream) noexcept : upstream(upstream) {}
+
+            node_pool(node_pool const&) = delete;
+            node_pool& operator=(node_pool const&) = delete;
+
+            ~node_pool() override {
+                release();
+            }
+
+            void release() noexcept {
+                while (chunks)
+                    give_back(std::exchange(chunks, chunks->next));
+                for (free_block*& list : free_lists)
+                    list = nullptr;
+                cursor = limit = nullptr;
+                next_chunk = first_chunk;
+            }
+        };
+    }
+
+    // Allocator policies. Every storage object owns an arena of its policy and
+    // allocates all of its nodes with arena.get(). If the arena supports bulk
+    // release, nodes of trivially destructible notes are never freed one by one.
+
+    // Nodes come from operator new, one allocation each.
+    struct default_allocator : detail::allocator_policy {
+        using allocator_type = std::allocator<std::byte>;
+
+        class arena {
+        public:
+            static constexpr bool bulk_release = false;
+
+            allocator_type get() const noexcept { return {}; }
+
+            void release() noexcept {}
+        };
+    };
+
+    // Every storage object gets its own pool: nodes freed by remove are reused
+    // by later inserts, and clearing or destroying the storage hands all its
+    // memory back at once. The pool requests memory from Upstream().
+    template <std::pmr::memory_resource* (*Upstream)() = std::pmr::get_default_resource>
+    struct pool_allocator : detail::allocator_policy {
+        using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+        class arena {
+            detail::node_pool pool{Upstream()};
+
+        public:
+            static constexpr bool bulk_release = true;
+
+            allocator_type get() noexcept { return &pool; }
+
+            void release() noexcept { pool.release(); }
+        };
+    };
+
+    // Nodes come straight from Resource(), e.g. a pool shared by many binders.
+    template <std::pmr::memory_resource* (*Resource)()>
+    struct resource_allocator : detail::allocator_policy {
+        using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+        class arena {
+        public:
+            static constexpr bool bulk_release = false;
+
+            allocator_type get() const noexcept { return Resource(); }
+
+            void release() noexcept {}
+        };
+    };
+}
+
+#endif //BINDER_ALLOCATOR_H
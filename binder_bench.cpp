@@ -0,0 +1,660 @@
+// Pomiary wydajności
+// g++ -Wall -Wextra -O2 -std=c++20 -DBENCH_NUM=... binder_bench.cpp -o binder_bench && ./binder_bench
+
+#include "binder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using cxx::binder;
+
+using std::cout;
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace {
+  // Zwraca czas wykonania f w milisekundach.
+  template <typename F>
+  double measure(F &&f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+  }
+
+  void report(char const *name, double ms, size_t operations) {
+    cout << name << ": " << ms << " ms, " << ms * 1e6 / static_cast<double>(operations)
+         << " ns/op\n";
+  }
+
+#if BENCH_NUM == 110
+  // Budujemy wiele skoroszytów po kilka notatek i wyszukujemy w nich każdą zakładkę.
+  template <typename B>
+  void small_binders(char const *name) {
+    constexpr size_t binders = 200000;
+    constexpr int notes = 5;
+
+    vector<B> vec(binders);
+    report((string(name) + ": build").c_str(), measure([&] {
+      for (B &b : vec)
+        for (int k = 0; k < notes; k++)
+          b.insert_front(k, k);
+    }), binders);
+
+    long sum = 0;
+    report((string(name) + ": lookups").c_str(), measure([&] {
+      for (int round = 0; round < 10; round++)
+        for (B const &b : vec)
+          for (int k = 0; k < notes; k++)
+            sum += b.read(k);
+    }), binders * notes * 10);
+    if (sum == 0)
+      cout << sum << "\n";
+  }
+#endif
+
+#if BENCH_NUM == 111 || BENCH_NUM == 112
+  // Sumujemy notatki pełnym przejściem skoroszytu zbudowanego dopisywaniem
+  // na koniec albo wstawianiem za losowe zakładki.
+  template <typename B>
+  void full_scans(char const *name, bool scattered) {
+    constexpr int notes = 1000000;
+    constexpr size_t scans = 20;
+
+    B b;
+    b.insert_front(0, 0);
+    unsigned seed = 1;
+    for (int i = 1; i < notes; i++) {
+      seed = seed * 1103515245u + 12345u;
+      b.insert_after(scattered ? static_cast<int>((seed >> 8) % static_cast<unsigned>(i)) : i - 1, i, i);
+    }
+
+    long sum = 0;
+    report(name, measure([&] {
+      for (size_t round = 0; round < scans; round++)
+        for (int v : b)
+          sum += v;
+    }), scans * notes);
+    if (sum == 0)
+      cout << sum << "\n";
+  }
+#endif
+
+#if BENCH_NUM == 113
+  // Szukamy losowych zakładek i sumujemy notatki skoroszytu z podaną liczbą
+  // notatek wstawianych za losowe zakładki.
+  template <typename B>
+  void lookups_and_scans(char const *name, int notes) {
+    constexpr size_t operations = 10000000;
+
+    B b;
+    b.insert_front(0, 0);
+    unsigned seed = 1;
+    for (int i = 1; i < notes; i++) {
+      seed = seed * 1103515245u + 12345u;
+      b.insert_after(static_cast<int>((seed >> 8) % static_cast<unsigned>(i)), i, i);
+    }
+    B const &cb = b;
+
+    cout << name << ", " << notes << " notes\n";
+    long sum = 0;
+    report("  read", measure([&] {
+      for (size_t i = 0; i < operations; i++) {
+        seed = seed * 1103515245u + 12345u;
+        sum += cb.read(static_cast<int>((seed >> 8) % static_cast<unsigned>(notes)));
+      }
+    }), operations);
+    report("  scan", measure([&] {
+      for (size_t round = 0; round < operations / notes; round++)
+        for (int v : cb)
+          sum += v;
+    }), operations / notes * notes);
+    if (sum == 0)
+      cout << sum << "\n";
+  }
+#endif
+
+#if BENCH_NUM == 114
+  // Budujemy skoroszyt z zakładkami key(0), ..., key(notes - 1) i szukamy w
+  // nim losowych zakładek.
+  template <typename B, typename MakeKey>
+  void build_and_read(char const *name, int notes, MakeKey const &key) {
+    constexpr size_t reads = 5000000;
+
+    using K = decltype(key(0));
+    vector<K> keys;
+    for (int i = 0; i < notes; i++)
+      keys.push_back(key(i));
+
+    B b;
+    report((string(name) + ", build").c_str(), measure([&] {
+      for (size_t round = 0; round < reads / notes / 10; round++) {
+        b.clear();
+        b.insert_front(keys[0], 0);
+        for (int i = 1; i < notes; i++)
+          b.insert_after(keys[i - 1], keys[i], i);
+      }
+    }), reads / notes / 10 * notes);
+
+    B const &cb = b;
+    long sum = 0;
+    unsigned seed = 1;
+    report((string(name) + ", read").c_str(), measure([&] {
+      for (size_t i = 0; i < reads; i++) {
+        seed = seed * 1103515245u + 12345u;
+        sum += cb.read(keys[(seed >> 8) % static_cast<unsigned>(notes)]);
+      }
+    }), reads);
+    if (sum == 0)
+      cout << sum << "\n";
+  }
+#endif
+
+#if BENCH_NUM == 115
+  // Kopiujemy skoroszyt z podaną liczbą notatek i zapisujemy do kopii, co
+  // kopiuje dane.
+  template <typename B>
+  void unshare(char const *name, int notes) {
+    B b;
+    b.insert_front(0, 0);
+    for (int i = 1; i < notes; i++)
+      b.insert_after(i - 1, i, i);
+
+    size_t rounds = std::max(1, 10000000 / notes);
+    report(name, measure([&] {
+      for (size_t round = 0; round < rounds; round++) {
+        B copy(b);
+        copy.read(0) = 1;
+      }
+    }), rounds);
+  }
+#endif
+
+#if BENCH_NUM == 116
+  // Kopiujemy dane skoroszytów różnej wielkości przy pierwszym zapisie.
+  // Kolejność zakładek jest inna niż kolejność notatek.
+  template <typename B, typename MakeKey>
+  void clone_throughput(char const *name, int max_notes, MakeKey const &key) {
+    cout << name << "\n";
+    for (int notes = 1000; notes <= max_notes; notes *= 10) {
+      B b;
+      b.insert_front(key(0), 0);
+      for (int i = 1; i < notes; i++)
+        b.insert_after(key(i - 1), key(i), i);
+
+      size_t rounds = std::max(1, 4000000 / notes);
+      double ms = measure([&] {
+        for (size_t round = 0; round < rounds; round++) {
+          B copy(b);
+          copy.read(key(0)) = 1;
+        }
+      });
+      report(("  " + std::to_string(notes) + " notes, per note").c_str(), ms, rounds * notes);
+    }
+  }
+#endif
+
+#if BENCH_NUM == 117
+  // Zapisujemy do jednej notatki kopii skoroszytu z dużymi wartościami, potem
+  // kopiujemy skoroszyt z wydaną referencją i przeglądamy wszystkie wartości.
+  template <typename B>
+  void value_writes(char const *name, int notes, size_t value_size) {
+    B b;
+    b.insert_front(0, vector<int>(value_size, 0));
+    for (int i = 1; i < notes; i++)
+      b.insert_after(i - 1, i, vector<int>(value_size, i));
+
+    cout << name << "\n";
+    size_t rounds = std::max(1, 1000000 / notes);
+    report("  unshare and write one value", measure([&] {
+      for (size_t round = 0; round < rounds; round++) {
+        B copy(b);
+        copy.read(static_cast<int>(round) % notes)[0] = 1;
+      }
+    }), rounds);
+
+    report("  copy after a mutable read", measure([&] {
+      for (size_t round = 0; round < rounds; round++) {
+        [[maybe_unused]] vector<int> &value = b.read(0);
+        B copy(b);
+      }
+    }), rounds);
+
+    long long sum = 0;
+    report("  scan, per note", measure([&] {
+      for (size_t round = 0; round < rounds; round++)
+        for (auto const &value : std::as_const(b))
+          sum += value[0];
+    }), rounds * notes);
+    cout << "  (" << sum << ")\n";
+  }
+#endif
+
+#if BENCH_NUM == 101
+  // Kopiujemy skoroszyt do wektora i niszczymy kopie, jak w binder_example.cpp.
+  template <typename B>
+  void copy_throughput(char const *name) {
+    constexpr size_t copies = 1000000;
+
+    B b;
+    b.insert_front(0, 0);
+    for (int i = 1; i < 1000; i++)
+      b.insert_after(i - 1, i, i);
+
+    vector<B> vec;
+    vec.reserve(copies);
+    double ms = measure([&] {
+      for (size_t i = 0; i < copies; i++)
+        vec.push_back(b);
+      vec.clear();
+    });
+    report(name, ms, copies);
+  }
+#endif
+
+#if BENCH_NUM == 102
+  // Każdy z wątków kopiuje ten sam skoroszyt (rywalizacja o licznik
+  // referencji) oraz kopiuje go i od razu modyfikuje kopię (klonowanie danych).
+  template <typename B>
+  void contended_copies(int threads) {
+    constexpr size_t copies = 200000;
+    constexpr size_t writes = 2000;
+
+    B shared;
+    shared.insert_front(0, 0);
+    for (int i = 1; i < 1000; i++)
+      shared.insert_after(i - 1, i, i);
+
+    auto run = [&](auto const &op, size_t operations) {
+      vector<std::thread> pool;
+      double ms = measure([&] {
+        for (int t = 0; t < threads; t++)
+          pool.emplace_back([&] {
+            for (size_t i = 0; i < operations; i++)
+              op();
+          });
+        for (auto &t : pool)
+          t.join();
+      });
+      return ms;
+    };
+
+    cout << threads << " threads\n";
+    report("copy", run([&] {
+      B copy(shared);
+    }, copies), copies * threads);
+    report("first write", run([&] {
+      B copy(shared);
+      copy.insert_front(-1, -1);
+    }, writes), writes * threads);
+  }
+#endif
+} // koniec anonimowej przestrzeni nazw
+
+int main() {
+// Przepustowość kopiowania dla obu liczników referencji.
+#if BENCH_NUM == 101
+  copy_throughput<binder<int, int>>("multi_threaded");
+  copy_throughput<binder<int, int, cxx::single_threaded>>("single_threaded");
+#endif
+
+// Czas kopiowania i pierwszego zapisu przy współdzieleniu danych między wątkami.
+#if BENCH_NUM == 102
+  for (int threads : {1, 2, 4, 8})
+    contended_copies<binder<int, int>>(threads);
+#endif
+
+// Budowanie skoroszytu po jednej notatce i całą partią naraz.
+#if BENCH_NUM == 103
+  constexpr int notes = 1000000;
+
+  vector<pair<int, int>> batch;
+  for (int i = 0; i < notes; i++)
+    batch.emplace_back(i, i);
+
+  report("insert_after", measure([&] {
+    binder<int, int> b;
+    b.insert_front(0, 0);
+    for (int i = 1; i < notes; i++)
+      b.insert_after(i - 1, i, i);
+  }), notes);
+
+  report("insert_range_front", measure([&] {
+    binder<int, int> b;
+    b.insert_range_front(batch.begin(), batch.end());
+  }), notes);
+
+  report("binder(first, last)", measure([&] {
+    binder<int, int> b(batch.begin(), batch.end());
+  }), notes);
+
+  report("insert_range_front (hash_index, pool_allocator)", measure([&] {
+    binder<int, int, cxx::hash_index<>, cxx::pool_allocator<>> b;
+    b.insert_range_front(batch.begin(), batch.end());
+  }), notes);
+#endif
+
+// Wstawianie notatek z dużą treścią przez kopiowanie i przez przeniesienie.
+#if BENCH_NUM == 104
+  constexpr size_t notes = 100000;
+  constexpr size_t payload = 4096;
+
+  auto prepare = [&] {
+    vector<pair<string, vector<char>>> batch;
+    batch.reserve(notes);
+    for (size_t i = 0; i < notes; i++)
+      batch.emplace_back("note no. " + std::to_string(i), vector<char>(payload, 'x'));
+    return batch;
+  };
+
+  auto copied = prepare();
+  report("insert_front (copy)", measure([&] {
+    binder<string, vector<char>> b;
+    for (auto const &[k, v] : copied)
+      b.insert_front(k, v);
+  }), notes);
+
+  auto moved = prepare();
+  report("insert_front (move)", measure([&] {
+    binder<string, vector<char>> b;
+    for (auto &[k, v] : moved)
+      b.insert_front(std::move(k), std::move(v));
+  }), notes);
+
+  report("emplace_front", measure([&] {
+    binder<string, vector<char>> b;
+    for (size_t i = 0; i < notes; i++)
+      b.emplace_front(std::piecewise_construct, std::forward_as_tuple(copied[i].first),
+                      std::forward_as_tuple(payload, 'x'));
+  }), notes);
+#endif
+
+// Wyszukiwanie notatek po string_view i przez zbudowanie klucza std::string.
+#if BENCH_NUM == 105
+  constexpr size_t notes = 10000;
+  constexpr size_t lookups = 2000000;
+
+  vector<string> keys;
+  for (size_t i = 0; i < notes; i++)
+    keys.push_back("a rather long key of note no. " + std::to_string(i));
+
+  binder<string, size_t> b;
+  b.insert_front(keys[0], 0);
+  for (size_t i = 1; i < notes; i++)
+    b.insert_after(keys[i - 1], keys[i], i);
+  binder<string, size_t> const &cb = b;
+
+  size_t sum = 0;
+  report("read(std::string(view))", measure([&] {
+    for (size_t i = 0; i < lookups; i++)
+      sum += cb.read(std::string(std::string_view(keys[i % notes])));
+  }), lookups);
+
+  report("read(view)", measure([&] {
+    for (size_t i = 0; i < lookups; i++)
+      sum += cb.read(std::string_view(keys[i % notes]));
+  }), lookups);
+  cout << "checksum: " << sum << "\n";
+#endif
+
+// Wyszukiwanie i wstawianie, gdy połowa zakładek jest nieobecna (lub już
+// obecna), z wyjątkami i bez nich.
+#if BENCH_NUM == 106
+  constexpr int notes = 10000;
+  constexpr int probes = 1000000;
+
+  binder<int, int> b;
+  b.insert_front(0, 0);
+  for (int i = 2; i < 2 * notes; i += 2)
+    b.insert_after(i - 2, i, i);
+  binder<int, int> const &cb = b;
+
+  long long sum = 0;
+  report("read + catch", measure([&] {
+    for (int i = 0; i < probes; i++) {
+      try {
+        sum += cb.read(i % (2 * notes));
+      } catch (std::invalid_argument const &) {
+        --sum;
+      }
+    }
+  }), probes);
+
+  report("find", measure([&] {
+    for (int i = 0; i < probes; i++) {
+      int const *v = cb.find(i % (2 * notes));
+      sum += v ? *v : -1;
+    }
+  }), probes);
+
+  report("insert_after + catch", measure([&] {
+    for (int i = 0; i < probes; i++) {
+      try {
+        b.insert_after(0, i % (2 * notes), i);
+        b.remove(i % (2 * notes));
+      } catch (std::invalid_argument const &) {
+        --sum;
+      }
+    }
+  }), probes);
+
+  report("try_insert_after", measure([&] {
+    for (int i = 0; i < probes; i++) {
+      if (b.try_insert_after(0, i % (2 * notes), i) == cxx::binder_status::ok)
+        b.remove(i % (2 * notes));
+      else
+        --sum;
+    }
+  }), probes);
+  cout << "checksum: " << sum << "\n";
+#endif
+
+// Odczyt stron po 20 notatek spod losowych pozycji: przejście od cbegin()
+// w domyślnej pamięci i cnth w ranked_storage.
+#if BENCH_NUM == 107
+  constexpr int notes = 100000;
+  constexpr int pages = 2000;
+  constexpr int page_size = 20;
+
+  binder<int, int> bl;
+  binder<int, int, cxx::ranked_storage> br;
+  bl.insert_front(0, 0);
+  br.insert_front(0, 0);
+  for (int i = 1; i < notes; i++) {
+    bl.insert_after(i - 1, i, i);
+    br.insert_after(i - 1, i, i);
+  }
+
+  long long sum = 0;
+  report("cbegin() + walk", measure([&] {
+    unsigned seed = 1;
+    for (int p = 0; p < pages; p++) {
+      seed = seed * 1103515245u + 12345u;
+      auto it = bl.cbegin();
+      std::advance(it, (seed >> 8) % (notes - page_size));
+      for (int i = 0; i < page_size; i++, ++it)
+        sum += *it;
+    }
+  }), pages);
+
+  report("cnth", measure([&] {
+    unsigned seed = 1;
+    for (int p = 0; p < pages; p++) {
+      seed = seed * 1103515245u + 12345u;
+      auto it = br.cnth((seed >> 8) % (notes - page_size));
+      for (int i = 0; i < page_size; i++, ++it)
+        sum += *it;
+    }
+  }), pages);
+
+  report("insert_after (ranked_storage)", measure([&] {
+    binder<int, int, cxx::ranked_storage> b;
+    b.insert_front(0, 0);
+    for (int i = 1; i < notes; i++)
+      b.insert_after(i - 1, i, i);
+  }), notes);
+  cout << "checksum: " << sum << "\n";
+#endif
+
+// Przestawianie notatek: usunięcie i ponowne wstawienie oraz move_*.
+#if BENCH_NUM == 108
+  constexpr int notes = 10000;
+  constexpr size_t moves = 1000000;
+
+  auto build = [&] {
+    binder<int, string> b;
+    b.insert_front(0, string(100, 'x'));
+    for (int i = 1; i < notes; i++)
+      b.insert_after(i - 1, i, string(100, 'x'));
+    return b;
+  };
+
+  binder<int, string> br = build();
+  report("remove + insert", measure([&] {
+    for (size_t i = 0; i < moves; i++) {
+      int k = static_cast<int>(i * 7919 % notes);
+      int prev_k = static_cast<int>(i * 104729 % notes);
+      string v = br.read(k);
+      br.remove(k);
+      if (i % 2 == 0 || prev_k == k)
+        br.insert_front(k, v);
+      else
+        br.insert_after(prev_k, k, v);
+    }
+  }), moves);
+
+  binder<int, string> bm = build();
+  report("move_front / move_after", measure([&] {
+    for (size_t i = 0; i < moves; i++) {
+      int k = static_cast<int>(i * 7919 % notes);
+      int prev_k = static_cast<int>(i * 104729 % notes);
+      if (i % 2 == 0 || prev_k == k)
+        bm.move_front(k);
+      else
+        bm.move_after(prev_k, k);
+    }
+  }), moves);
+#endif
+
+#if BENCH_NUM == 109
+  constexpr int notes = 100000;
+  constexpr int batch = 100;
+  constexpr size_t rounds = 10000;
+
+  auto build = [&](int first, int count) {
+    binder<int, string> b;
+    for (int i = first + count; i-- > first;)
+      b.insert_front(i, string(100, 'x'));
+    return b;
+  };
+
+  vector<pair<int, string>> notes_batch;
+  for (int i = notes; i < notes + batch; i++)
+    notes_batch.emplace_back(i, string(100, 'x'));
+
+  binder<int, string> br = build(0, notes);
+  report("insert_range + remove", measure([&] {
+    for (size_t i = 0; i < rounds; i++) {
+      br.insert_range_after(notes - 1, notes_batch.begin(), notes_batch.end());
+      for (int k = notes; k < notes + batch; k++)
+        br.remove(k);
+    }
+  }), rounds);
+
+  binder<int, string> bs = build(0, notes);
+  binder<int, string> tail = build(notes, batch);
+  report("splice_back + split_after", measure([&] {
+    for (size_t i = 0; i < rounds; i++) {
+      bs.splice_back(std::move(tail));
+      tail = bs.split_after(notes - 1);
+    }
+  }), rounds);
+#endif
+
+#if BENCH_NUM == 110
+  small_binders<binder<int, int>>("list_storage");
+  small_binders<binder<int, int, cxx::small_storage<>>>("small_storage");
+#endif
+
+#if BENCH_NUM == 111
+  full_scans<binder<int, int>>("list_storage, appended", false);
+  full_scans<binder<int, int, cxx::flat_storage>>("flat_storage, appended", false);
+  full_scans<binder<int, int>>("list_storage, inserted in the middle", true);
+  full_scans<binder<int, int, cxx::flat_storage>>("flat_storage, inserted in the middle", true);
+#endif
+
+#if BENCH_NUM == 112
+  full_scans<binder<int, int>>("list_storage, inserted in the middle", true);
+  full_scans<binder<int, int, cxx::flat_storage>>("flat_storage, inserted in the middle", true);
+  full_scans<binder<int, int, cxx::unrolled_storage<>>>("unrolled_storage, appended", false);
+  full_scans<binder<int, int, cxx::unrolled_storage<>>>("unrolled_storage, inserted in the middle", true);
+#endif
+
+// Zakładki całkowite: drzewo i lista, tablica haszująca i osobne wektory
+// przeszukiwane instrukcjami SIMD.
+#if BENCH_NUM == 113
+  for (int notes : {16, 128, 1024}) {
+    lookups_and_scans<binder<int, int>>("list_storage", notes);
+    lookups_and_scans<binder<int, int, cxx::hash_index<>>>("list_storage, hash_index", notes);
+    lookups_and_scans<binder<int, int, cxx::soa_storage>>("soa_storage", notes);
+  }
+#endif
+
+// Indeks wybrany na podstawie typu zakładek, indeks drzewiasty i tablica
+// adresowana bezpośrednio.
+#if BENCH_NUM == 114
+  auto small = [](int i) { return static_cast<char>(i); };
+  auto integral = [](int i) { return i * 7919; };
+  auto text = [](int i) { return "a rather long key of note no. " + std::to_string(i); };
+
+  build_and_read<binder<char, int, cxx::ordered_index<>>>("char, ordered_index", 200, small);
+  build_and_read<binder<char, int>>("char, default (hash_index)", 200, small);
+  build_and_read<binder<char, int, cxx::direct_index>>("char, direct_index", 200, small);
+  build_and_read<binder<int, int, cxx::ordered_index<>>>("int, ordered_index", 10000, integral);
+  build_and_read<binder<int, int>>("int, default (hash_index)", 10000, integral);
+  build_and_read<binder<string, int, cxx::ordered_index<>>>("string, ordered_index", 10000, text);
+  build_and_read<binder<string, int>>("string, default (hash_index, string_hash)", 10000, text);
+#endif
+
+// Kopiowanie danych skoroszytu przy pierwszym zapisie.
+#if BENCH_NUM == 115
+  for (int notes : {1000, 1000000}) {
+    cout << notes << " notes\n";
+    unshare<binder<int, int>>("list_storage", notes);
+    unshare<binder<int, int, cxx::flat_storage>>("flat_storage", notes);
+    unshare<binder<int, int, cxx::soa_storage>>("soa_storage (bulk copy)", notes);
+  }
+#endif
+
+// Przepustowość kopiowania danych dla indeksów drzewiastego i haszującego.
+#if BENCH_NUM == 116
+  auto scrambled = [](int i) { return static_cast<int>(static_cast<unsigned>(i) * 2654435761u); };
+  auto text = [&](int i) { return "a rather long key of note no. " + std::to_string(scrambled(i)); };
+
+  clone_throughput<binder<int, int, cxx::ordered_index<>>>("list_storage, ordered_index", 10000000, scrambled);
+  clone_throughput<binder<int, int, cxx::hash_index<>>>("list_storage, hash_index", 10000000, scrambled);
+  clone_throughput<binder<int, int, cxx::ranked_storage>>("ranked_storage, hash_index", 10000000, scrambled);
+  clone_throughput<binder<string, int, cxx::ordered_index<>>>("list_storage, ordered_index, string keys",
+                                                               1000000, text);
+#endif
+
+// Zapis do współdzielonego skoroszytu z wartościami w osobnych komórkach.
+#if BENCH_NUM == 117
+  for (int notes : {1000, 100000}) {
+    cout << notes << " notes of 256 ints\n";
+    value_writes<binder<int, vector<int>>>("list_storage", notes, 256);
+    value_writes<binder<int, vector<int>, cxx::shared_values<>>>("shared_values<list_storage>", notes, 256);
+  }
+#endif
+}
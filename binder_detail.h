@@ -0,0 +1,150 @@
+#ifndef BINDER_DETAIL_H
+#define BINDER_DETAIL_H
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace cxx::detail {
+    // Categories of binder policies. A policy derives from its category and
+    // binder<K, V, Policies...> picks at most one policy of each category.
+    struct storage_policy {};
+    struct index_policy {};
+    struct allocator_policy {};
+    struct threading_policy {};
+
+    template <typename P>
+    inline constexpr bool is_policy_v =
+        std::is_base_of_v<storage_policy, P> || std::is_base_of_v<index_policy, P> ||
+        std::is_base_of_v<allocator_policy, P> || std::is_base_of_v<threading_policy, P>;
+
+    template <typename... Policies>
+    struct policy_list {};
+
+    template <typename Category, typename Default, typename Policies>
+    struct select_policy;
+
+    template <typename Category, typename Default>
+    struct select_policy<Category, Default, policy_list<>> {
+        using type = Default;
+    };
+
+    template <typename Category, typename Default, typename P, typename... Rest>
+    struct select_policy<Category, Default, policy_list<P, Rest...>>
+        : std::conditional_t<std::is_base_of_v<Category, P>, std::type_identity<P>,
+                             select_policy<Category, Default, policy_list<Rest...>>> {};
+
+    template <typename Category, typename Default, typename Policies>
+    using select_policy_t = typename select_policy<Category, Default, Policies>::type;
+
+    // Requests a copy of the storage that shares no values with the original,
+    // needed once a mutable reference to a value has been handed out.
+    struct deep_copy_t {
+        explicit deep_copy_t() = default;
+    };
+
+    inline constexpr deep_copy_t deep_copy{};
+
+    // Reference counters of ref_counted objects.
+    class atomic_count {
+        std::atomic<std::size_t> n{0};
+
+    public:
+        void retain() noexcept {
+            n.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Returns true if the last reference was dropped.
+        bool release() noexcept {
+            return n.fetch_sub(1, std::memory_order_acq_rel) == 1;
+        }
+
+        std::size_t load() const noexcept {
+            return n.load(std::memory_order_acquire);
+        }
+    };
+
+    class plain_count {
+        std::size_t n = 0;
+
+    public:
+        void retain() noexcept { ++n; }
+
+        bool release() noexcept { return --n == 0; }
+
+        std::size_t load() const noexcept { return n; }
+    };
+
+    // Base for objects owned through counted_ptr. The count is never copied.
+    template <typename Count = atomic_count>
+    class ref_counted {
+        template <typename T>
+        friend class counted_ptr;
+
+        mutable Count refs;
+
+    protected:
+        ref_counted() noexcept = default;
+        ref_counted(const ref_counted&) noexcept {}
+        ref_counted& operator=(const ref_counted&) noexcept { return *this; }
+        ~ref_counted() = default;
+    };
+
+    // Intrusive shared pointer: one allocation per object, no control block.
+    template <typename T>
+    class counted_ptr {
+        T* ptr = nullptr;
+
+        void retain() const noexcept {
+            if (ptr)
+                ptr->refs.retain();
+        }
+
+        void release() noexcept {
+            if (ptr && ptr->refs.release())
+                delete ptr;
+        }
+
+    public:
+        counted_ptr() noexcept = default;
+
+        counted_ptr(std::nullptr_t) noexcept {}
+
+        explicit counted_ptr(T* p) noexcept : ptr(p) {
+            retain();
+        }
+
+        counted_ptr(const counted_ptr& rhs) noexcept : ptr(rhs.ptr) {
+            retain();
+        }
+
+        counted_ptr(counted_ptr&& rhs) noexcept : ptr(std::exchange(rhs.ptr, nullptr)) {}
+
+        ~counted_ptr() {
+            release();
+        }
+
+        counted_ptr& operator=(counted_ptr rhs) noexcept {
+            std::swap(ptr, rhs.ptr);
+            return *this;
+        }
+
+        template <typename... Args>
+        static counted_ptr make(Args&&... args) {                              // strong guarantee
+            return counted_ptr(new T(std::forward<Args>(args)...));
+        }
+
+        T* get() const noexcept { return ptr; }
+        T& operator*() const noexcept { return *ptr; }
+        T* operator->() const noexcept { return ptr; }
+
+        explicit operator bool() const noexcept { return ptr != nullptr; }
+
+        bool unique() const noexcept {
+            return ptr && ptr->refs.load() == 1;
+        }
+    };
+}
+
+#endif //BINDER_DETAIL_H
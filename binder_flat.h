@@ -0,0 +1,275 @@
+#ifndef BINDER_FLAT_H
+#define BINDER_FLAT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "binder_allocator.h"
+#include "binder_detail.h"
+#include "binder_index.h"
+
+namespace cxx {
+    namespace detail {
+        // The part of a note owned by flat_storage or unrolled_storage inside
+        // the index node: the position of the note's slot.
+        template <typename Node, typename S>
+        struct flat_body {
+            S slot;
+
+            template <typename Tuple>
+            flat_body(std::piecewise_construct_t, Tuple&& args)
+                : slot(std::make_from_tuple<S>(std::forward<Tuple>(args))) {}
+        };
+
+        // The order of the notes of flat_storage and soa_storage: slots of a
+        // vector whose elements have prev and next slot positions.
+        class slot_list {
+        protected:
+            static constexpr size_t none = ~size_t(0);
+
+            size_t head = none;
+            size_t tail = none;
+            size_t count = 0;
+
+            // Links slot i after position, or at the front if position is none.
+            template <typename Slots>
+            void link_after(Slots& slots, size_t position, size_t i) noexcept {
+                slots[i].prev = position;
+                slots[i].next = position == none ? head : slots[position].next;
+                (slots[i].next == none ? tail : slots[slots[i].next].prev) = i;
+                (position == none ? head : slots[position].next) = i;
+                ++count;
+            }
+
+            template <typename Slots>
+            void unlink(Slots& slots, size_t i) noexcept {
+                (slots[i].prev == none ? head : slots[slots[i].prev].next) = slots[i].next;
+                (slots[i].next == none ? tail : slots[slots[i].next].prev) = slots[i].prev;
+                --count;
+            }
+
+            // After a rebuild, in which slot j got the links j - 1 and j + 1:
+            // the first count slots, in order, are the whole list.
+            template <typename Slots>
+            void link_rebuilt(Slots& slots) noexcept {
+                head = tail = none;
+                if (count > 0) {
+                    slots[0].prev = none;
+                    slots[count - 1].next = none;
+                    head = 0;
+                    tail = count - 1;
+                }
+            }
+
+            void reset() noexcept {
+                head = tail = none;
+                count = 0;
+            }
+        };
+
+        // Builds the value of a slot from the elements of the tuple.
+        template <typename V, typename VT>
+        void build_slot_value(std::optional<V>& value, VT&& value_args) {       // strong guarantee
+            std::apply([&](auto&&... args) { value.emplace(std::forward<decltype(args)>(args)...); },
+                       std::forward<VT>(value_args));
+        }
+    }
+
+    // Storage with the values in one contiguous vector of slots. The order of
+    // the notes is kept by prev/next slot positions; a new note takes the
+    // slot at the back and is linked after its predecessor, so inserting in
+    // the middle moves nothing. Removal leaves a tombstone. When the vector is
+    // full, the next insertion rebuilds it in the order of the notes without
+    // tombstones, with room for as many notes again, so the cost is amortized
+    // O(1) and a full scan after mostly appending reads the slots in memory
+    // order. The key index policy finds the slot of a key; its nodes hold the
+    // keys. Unsharing copies every note.
+    struct flat_storage : detail::storage_policy {
+        template <typename K, typename V, typename Policies>
+        class data : detail::slot_list {
+            using index_policy = detail::select_policy_t<detail::index_policy, default_index_t<K>, Policies>;
+            using allocator_policy = detail::select_policy_t<detail::allocator_policy, default_allocator, Policies>;
+            using allocator_type = typename allocator_policy::allocator_type;
+            using iters_map = typename index_policy::template index<K, size_t, allocator_type, detail::flat_body>;
+            using node = typename iters_map::node;
+
+            static constexpr size_t min_capacity = 8;
+
+            // A tombstone has no node and no value.
+            struct slot {
+                node* n;
+                size_t prev;
+                size_t next;
+                std::optional<V> value;
+            };
+
+            using slots_vector = std::vector<slot, typename std::allocator_traits<allocator_type>::template rebind_alloc<slot>>;
+
+            typename allocator_policy::arena arena;
+            iters_map iters{arena.get()};
+            slots_vector slots{arena.get()};
+
+            static size_t& slot_of(node* n) noexcept { return iters_map::body(n).slot; }
+
+            // Inserts a note after position, or at the front if position is
+            // none. make(i) adds the key to the index with slot i and returns
+            // its node, or null if the key is present (then none is returned).
+            template <typename Make, typename VT>
+            size_t add(size_t position, Make const& make, VT&& value_args) {
+                if (slots.size() == slots.capacity())
+                    return add_rebuilding(position, make, std::forward<VT>(value_args));
+
+                node* n = make(slots.size());                                   // strong guarantee
+                if (!n)
+                    return none;
+
+                slots.push_back({n, none, none, std::nullopt});                // no-throw, the room is there
+                try {
+                    detail::build_slot_value(slots.back().value, std::forward<VT>(value_args));
+                } catch (...) {
+                    slots.pop_back();
+                    iters.erase(n);
+                    throw;
+                }
+                link_after(slots, position, slots.size() - 1);
+                return slots.size() - 1;
+            }
+
+            // Like add, but first moves the notes in their order to a new
+            // vector twice their number, dropping the tombstones. Values are
+            // moved if that cannot throw and copied otherwise, so a failure
+            // leaves the storage as it was.
+            template <typename Make, typename VT>
+            size_t add_rebuilding(size_t position, Make const& make, VT&& value_args) {
+                std::optional<V> value;
+                detail::build_slot_value(value, std::forward<VT>(value_args));  // strong guarantee
+
+                slots_vector rebuilt(slots.get_allocator());
+                rebuilt.reserve(std::max(min_capacity, 2 * (count + 1)));      // strong guarantee
+
+                node* n = make(count);                                          // strong guarantee
+                if (!n)
+                    return none;
+
+                try {
+                    for (size_t i = head; i != none; i = slots[i].next)
+                        rebuilt.push_back({slots[i].n, rebuilt.size() - 1, rebuilt.size() + 1,
+                                           std::move_if_noexcept(slots[i].value)});
+                    rebuilt.push_back({n, none, none, std::move_if_noexcept(value)});
+                } catch (...) {
+                    iters.erase(n);
+                    throw;
+                }
+
+                node* p = position == none ? nullptr : slots[position].n;      // no-throw from here
+                slots.swap(rebuilt);
+                for (size_t i = 0; i < slots.size(); i++)
+                    slot_of(slots[i].n) = i;
+                link_rebuilt(slots);
+                link_after(slots, p ? slot_of(p) : none, count);
+                return count - 1;
+            }
+
+        public:
+            using handle = size_t;
+
+            template <typename Q>
+            static constexpr bool transparent_for = index_policy::template transparent_for<K, Q>;
+
+            data() = default;
+
+            data(data const& other) {
+                iters.reserve(other.count);
+                slots.reserve(other.count);
+                for (size_t j = other.head; j != none; j = other.slots[j].next)
+                    add(tail, [&](size_t i) { return iters.emplace(other.key(j), i); },
+                        std::forward_as_tuple(other.value(j)));
+            }
+
+            data(data const& other, detail::deep_copy_t) : data(other) {}
+
+            size_t size() const noexcept { return count; }
+
+            handle begin() const noexcept { return head; }
+            handle last() const noexcept { return tail; }
+            handle end() const noexcept { return none; }
+            handle next(handle h) const noexcept { return slots[h].next; }
+            handle prev(handle h) const noexcept { return slots[h].prev; }
+
+            template <typename Q>
+            handle find(Q const& k) const {
+                node* n = iters.find(k);
+                return n ? iters_map::body(n).slot : none;
+            }
+
+            K const& key(handle h) const noexcept { return iters_map::key_of(slots[h].n); }
+
+            V const& value(handle h) const noexcept { return *slots[h].value; }
+
+            V& value_for_write(handle h) noexcept { return *slots[h].value; }
+
+            template <typename KK, typename VV>
+            handle insert_front(KK&& k, VV&& v) {
+                return insert_after(none, std::forward<KK>(k), std::forward<VV>(v));
+            }
+
+            template <typename KK, typename VV>
+            handle insert_after(handle position, KK&& k, VV&& v) {
+                return add(position, [&](size_t i) { return iters.emplace(std::forward<KK>(k), i); },
+                           std::forward_as_tuple(std::forward<VV>(v)));
+            }
+
+            // Inserts at the back; returns end() if k is already present.
+            template <typename KK, typename VV>
+            handle try_append(KK&& k, VV&& v) {
+                return add(tail, [&](size_t i) { return iters.try_emplace_back(std::forward<KK>(k), i); },
+                           std::forward_as_tuple(std::forward<VV>(v)));
+            }
+
+            // Builds the key and the value from the elements of the tuples and
+            // inserts the note after position, or at the front if position is
+            // end(). Returns end() if the key is already present.
+            template <typename KT, typename VT>
+            handle try_emplace_after(handle position, KT&& key_args, VT&& value_args) {
+                return add(position,
+                           [&](size_t i) {
+                               return iters.try_emplace_piecewise(std::forward<KT>(key_args),
+                                                                  std::forward_as_tuple(i));
+                           },
+                           std::forward<VT>(value_args));
+            }
+
+            // Moves the note h after position, or to the front if position is
+            // end(). The note stays in its slot.
+            void relink_after(handle position, handle h) noexcept {
+                unlink(slots, h);
+                link_after(slots, position, h);
+            }
+
+            // Leaves a tombstone, or shrinks the vector if h is at its back.
+            void erase(handle position) noexcept {
+                node* n = slots[position].n;
+                unlink(slots, position);
+                slots[position].n = nullptr;
+                slots[position].value.reset();
+                iters.erase(n);
+                while (!slots.empty() && !slots.back().n)
+                    slots.pop_back();
+            }
+
+            void clear() noexcept {
+                iters.clear();
+                slots.clear();
+                reset();
+            }
+        };
+    };
+}
+
+#endif //BINDER_FLAT_H
@@ -0,0 +1,708 @@
+#ifndef BINDER_INDEX_H
+#define BINDER_INDEX_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "binder_detail.h"
+
+namespace cxx {
+    namespace detail {
+        // The part of a note owned by the storage: links of the insertion
+        // order and the value. Index nodes embed it next to the key and the
+        // index links, so a note costs a single allocation.
+        template <typename Node, typename V>
+        struct note_body {
+            Node* prev = nullptr;
+            Node* next = nullptr;
+            V value;
+
+            // The value is built from the elements of the tuple args.
+            template <typename Tuple>
+            note_body(std::piecewise_construct_t, Tuple&& args)
+                : value(std::make_from_tuple<V>(std::forward<Tuple>(args))) {}
+        };
+
+        // Open-addressing map from the nodes of an index to their copies in a
+        // clone, for indexes whose copies do not sit where the originals do.
+        template <typename Node>
+        class node_map {
+            std::vector<std::pair<Node const*, Node*>> slots;
+
+            size_t home(Node const* n) const noexcept {
+                auto h = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(n));
+                return static_cast<size_t>((h * 0x9e3779b97f4a7c15ULL) >> 32) & (slots.size() - 1);
+            }
+
+        public:
+            explicit node_map(size_t n) : slots(std::bit_ceil(n + n / 4 + 1)) {}
+
+            void add(Node const* from, Node* to) noexcept {
+                size_t i = home(from);
+                while (slots[i].first)
+                    i = (i + 1) & (slots.size() - 1);
+                slots[i] = {from, to};
+            }
+
+            Node* operator()(Node const* from) const noexcept {
+                size_t i = home(from);
+                while (slots[i].first != from)
+                    i = (i + 1) & (slots.size() - 1);
+                return slots[i].second;
+            }
+        };
+
+        // Spreads the bits of a hash, so weak hashes (the identity for
+        // integers) still fill the low bits used as a table position.
+        inline size_t mix_hash(size_t h) noexcept {
+            if constexpr (sizeof(size_t) >= 8) {
+                h ^= h >> 33;
+                h *= 0xff51afd7ed558ccdULL;
+                h ^= h >> 33;
+            } else {
+                h ^= h >> 16;
+                h *= 0x45d9f3bU;
+                h ^= h >> 16;
+            }
+            return h;
+        }
+
+        // The default order of ordered_index: std::less<K>, which a program
+        // may specialize for its own K, or the transparent std::less<> for
+        // standard string keys, whose order std::less<K> cannot change and
+        // which are found by views without building a string. Other keys,
+        // arithmetic ones included, are converted to K before comparing, as
+        // hash_index does, so 2.5 finds the key 2 of an int binder.
+        template <typename K>
+        struct default_less {
+            using type = std::less<K>;
+        };
+
+        template <typename CharT, typename Traits, typename Alloc>
+        struct default_less<std::basic_string<CharT, Traits, Alloc>> {
+            using type = std::less<>;
+        };
+    }
+
+    // Key index policies. An index owns the nodes of the notes: it allocates
+    // them with Alloc in emplace, frees them in erase and clear, and finds
+    // them by key. forget() drops all nodes without destroying or freeing
+    // them, for when the allocator's memory is about to be released at once.
+    // clone_from(other) fills an empty index with copies of the nodes of
+    // other in O(n), without comparing or hashing keys, and returns a
+    // function mapping each node of other to its copy. Body<node, V> is the
+    // part of a node owned by the storage; it holds the value and is built
+    // from std::piecewise_construct and a tuple of the value's constructor
+    // arguments. Clones copy it as it is.
+
+    // Index kept in a std::map ordered by Compare. When Compare is void,
+    // std::string keys are compared by std::less<>, so they can be found by
+    // other types, and other keys by std::less<K>.
+    template <typename Compare = void>
+    struct ordered_index : detail::index_policy {
+        static constexpr bool ordered = true;
+
+        template <typename K>
+        using compare = std::conditional_t<std::is_void_v<Compare>, typename detail::default_less<K>::type, Compare>;
+
+        // Whether notes can be found by a Q without building a K from it.
+        template <typename K, typename Q>
+        static constexpr bool transparent_for = requires { typename compare<K>::is_transparent; } &&
+            std::is_invocable_r_v<bool, compare<K> const&, K const&, Q const&> &&
+            std::is_invocable_r_v<bool, compare<K> const&, Q const&, K const&>;
+
+        template <typename K, typename V, typename Alloc = std::allocator<std::byte>,
+                  template <typename, typename> class Body = detail::note_body>
+        class index {
+            struct Note;
+            using iters_map = std::map<K, Note, compare<K>,
+                typename std::allocator_traits<Alloc>::template rebind_alloc<std::pair<K const, Note>>>;
+
+        public:
+            // A note is the map node itself.
+            using node = typename iters_map::value_type;
+            using body_type = Body<node, V>;
+
+        private:
+            struct Note : body_type {
+                typename iters_map::iterator self;
+
+                template <typename Tuple>
+                Note(std::piecewise_construct_t, Tuple&& args)
+                    : body_type(std::piecewise_construct, std::forward<Tuple>(args)) {}
+            };
+
+            iters_map iters;
+
+        public:
+            explicit index(Alloc const& alloc = Alloc()) : iters(alloc) {}
+            index(index const&) = delete;
+            index& operator=(index const&) = delete;
+
+            static K const& key_of(node const* n) noexcept { return n->first; }
+            static body_type& body(node* n) noexcept { return n->second; }
+            static body_type const& body(node const* n) noexcept { return n->second; }
+
+            template <typename Q>
+            node* find(Q const& k) const {
+                auto it = iters.find(k);
+                if (it == iters.end())
+                    return nullptr;
+                return const_cast<node*>(&*it);
+            }
+
+            template <typename KK, typename VV>
+            node* emplace(KK&& k, VV&& v) {                                    // strong guarantee
+                auto it = iters.try_emplace(std::forward<KK>(k), std::piecewise_construct,
+                                            std::forward_as_tuple(std::forward<VV>(v))).first;
+                it->second.self = it;
+                return &*it;
+            }
+
+            // The map is copied node by node along its structure.
+            detail::node_map<node> clone_from(index const& other) {          // strong guarantee
+                detail::node_map<node> copy_of(other.iters.size());
+                iters = iters_map(other.iters, iters.get_allocator());
+                auto from = other.iters.begin();
+                for (auto it = iters.begin(); it != iters.end(); ++it, ++from) {
+                    it->second.self = it;
+                    copy_of.add(&*from, &*it);
+                }
+                return copy_of;
+            }
+
+            // Like emplace, but expects k to be the greatest key so far
+            // (amortized O(1) then). Returns null if k is already present.
+            template <typename KK, typename VV>
+            node* try_emplace_back(KK&& k, VV&& v) {                           // strong guarantee
+                size_t size = iters.size();
+                auto it = iters.try_emplace(iters.end(), std::forward<KK>(k), std::piecewise_construct,
+                                            std::forward_as_tuple(std::forward<VV>(v)));
+                if (iters.size() == size)
+                    return nullptr;
+                it->second.self = it;
+                return &*it;
+            }
+
+            // Builds the key and the value from the elements of the tuples.
+            // Returns null if the key is already present.
+            template <typename KT, typename VT>
+            node* try_emplace_piecewise(KT&& key_args, VT&& value_args) {      // strong guarantee
+                auto [it, inserted] = iters.emplace(
+                    std::piecewise_construct, std::forward<KT>(key_args),
+                    std::forward_as_tuple(std::piecewise_construct, std::forward<VT>(value_args)));
+                if (!inserted)
+                    return nullptr;
+                it->second.self = it;
+                return &*it;
+            }
+
+            // Whether adopt neither allocates nor throws.
+            static constexpr bool nothrow_transfer = std::allocator_traits<Alloc>::is_always_equal::value &&
+                std::is_nothrow_invocable_v<compare<K> const&, K const&, K const&>;
+
+            // Takes over the node n of from, whose key must be absent here.
+            // The node is relinked, not copied.
+            void adopt(index& from, node* n) noexcept(nothrow_transfer) {
+                auto it = iters.insert(from.iters.extract(n->second.self)).position;
+                it->second.self = it;
+            }
+
+            void erase(node* n) noexcept {
+                iters.erase(n->second.self);
+            }
+
+            void reserve(size_t) noexcept {}
+
+            void clear() noexcept {
+                iters.clear();
+            }
+
+            void forget() noexcept {
+                auto alloc = iters.get_allocator();
+                ::new (static_cast<void*>(&iters)) iters_map(alloc);
+            }
+        };
+    };
+
+    // Open-addressing (linear probing) hash index over Hash and KeyEqual
+    // (std::hash<K> and std::equal_to<K> when void). Each node caches the hash
+    // of its key, so rehashing and erasing never call Hash nor KeyEqual.
+    template <typename Hash = void, typename KeyEqual = void>
+    struct hash_index : detail::index_policy {
+        static constexpr bool ordered = false;
+
+        template <typename K>
+        using hasher = std::conditional_t<std::is_void_v<Hash>, std::hash<K>, Hash>;
+
+        template <typename K>
+        using key_equal = std::conditional_t<std::is_void_v<KeyEqual>, std::equal_to<K>, KeyEqual>;
+
+        // Whether notes can be found by a Q without building a K from it.
+        template <typename K, typename Q>
+        static constexpr bool transparent_for =
+            requires { typename hasher<K>::is_transparent; typename key_equal<K>::is_transparent; } &&
+            std::is_invocable_r_v<size_t, hasher<K> const&, Q const&> &&
+            std::is_invocable_r_v<bool, key_equal<K> const&, K const&, Q const&>;
+
+        template <typename K, typename V, typename Alloc = std::allocator<std::byte>,
+                  template <typename, typename> class Body = detail::note_body>
+        class index {
+        public:
+            struct node;
+            using body_type = Body<node, V>;
+
+            struct node : body_type {
+                K key;
+                size_t tag = 0;
+
+                template <typename KT, typename VT>
+                node(KT&& key_args, VT&& value_args)
+                    : body_type(std::piecewise_construct, std::forward<VT>(value_args)),
+                      key(std::make_from_tuple<K>(std::forward<KT>(key_args))) {}
+            };
+
+        private:
+            static constexpr size_t occupied = ~(~size_t(0) >> 1);
+            static constexpr size_t min_capacity = 8;
+
+            struct slot {
+                size_t tag = 0;                                                 // 0 marks an empty slot
+                node* n = nullptr;
+            };
+
+            using node_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<node>;
+            using node_traits = std::allocator_traits<node_alloc>;
+            using slots_vector = std::vector<slot, typename std::allocator_traits<Alloc>::template rebind_alloc<slot>>;
+
+            slots_vector slots;
+            size_t count = 0;
+            [[no_unique_address]] node_alloc alloc;
+            [[no_unique_address]] hasher<K> hash;
+            [[no_unique_address]] key_equal<K> equal;
+
+            template <typename Q>
+            size_t tag_of(Q const& k) const {
+                return detail::mix_hash(hash(k)) | occupied;
+            }
+
+            size_t mask() const noexcept { return slots.size() - 1; }
+
+            void place(slot s) noexcept {
+                size_t i = s.tag & mask();
+                while (slots[i].tag != 0)
+                    i = (i + 1) & mask();
+                slots[i] = s;
+            }
+
+            template <typename Q>
+            node* lookup(size_t tag, Q const& k) const {
+                if (count == 0)
+                    return nullptr;
+
+                for (size_t i = tag & mask();; i = (i + 1) & mask()) {
+                    slot const& s = slots[i];
+                    if (s.tag == 0)
+                        return nullptr;
+                    if (s.tag == tag && equal(s.n->key, k))
+                        return s.n;
+                }
+            }
+
+            template <typename KT, typename VT>
+            node* make_node(KT&& key_args, VT&& value_args) {                  // strong guarantee
+                node* n = node_traits::allocate(alloc, 1);
+                try {
+                    node_traits::construct(alloc, n, std::forward<KT>(key_args), std::forward<VT>(value_args));
+                } catch (...) {
+                    node_traits::deallocate(alloc, n, 1);
+                    throw;
+                }
+                return n;
+            }
+
+            void link(size_t tag, node* n) noexcept {
+                n->tag = tag;
+                place({tag, n});
+                ++count;
+            }
+
+            template <typename KK, typename VV>
+            node* add(size_t tag, KK&& k, VV&& v) {                            // strong guarantee
+                reserve(count + 1);
+                node* n = make_node(std::forward_as_tuple(std::forward<KK>(k)),
+                                    std::forward_as_tuple(std::forward<VV>(v)));
+                link(tag, n);
+                return n;
+            }
+
+            void destroy(node* n) noexcept {
+                node_traits::destroy(alloc, n);
+                node_traits::deallocate(alloc, n, 1);
+            }
+
+            // The position of n in the slots.
+            size_t slot_of(node const* n) const noexcept {
+                size_t i = n->tag & mask();
+                while (slots[i].n != n)
+                    i = (i + 1) & mask();
+                return i;
+            }
+
+            // Removes n from the slots, keeping the node.
+            void detach(node* n) noexcept {
+                size_t i = slot_of(n);
+
+                // Backward shift deletion keeps probe sequences without gaps.
+                for (size_t j = (i + 1) & mask(); slots[j].tag != 0; j = (j + 1) & mask()) {
+                    size_t home = slots[j].tag & mask();
+                    if (((j - home) & mask()) >= ((j - i) & mask())) {
+                        slots[i] = slots[j];
+                        i = j;
+                    }
+                }
+                slots[i] = slot{};
+                --count;
+            }
+
+        public:
+            explicit index(Alloc const& alloc = Alloc()) : slots(alloc), alloc(alloc) {}
+            index(index const&) = delete;
+            index& operator=(index const&) = delete;
+
+            ~index() {
+                clear();
+            }
+
+            static K const& key_of(node const* n) noexcept { return n->key; }
+            static body_type& body(node* n) noexcept { return *n; }
+            static body_type const& body(node const* n) noexcept { return *n; }
+
+            template <typename Q>
+            node* find(Q const& k) const {
+                return lookup(tag_of(k), k);
+            }
+
+            template <typename KK, typename VV>
+            node* emplace(KK&& k, VV&& v) {                                    // strong guarantee
+                size_t tag = tag_of(k);
+                return add(tag, std::forward<KK>(k), std::forward<VV>(v));
+            }
+
+            // Every copy takes the slot of its original.
+            auto clone_from(index const& other) {                               // strong guarantee
+                slots_vector copy(other.slots.size(), slots.get_allocator());
+                slots.swap(copy);
+                try {
+                    for (size_t i = 0; i < slots.size(); i++)
+                        if (other.slots[i].n) {
+                            node* n = node_traits::allocate(alloc, 1);
+                            try {
+                                node_traits::construct(alloc, n, *other.slots[i].n);
+                            } catch (...) {
+                                node_traits::deallocate(alloc, n, 1);
+                                throw;
+                            }
+                            slots[i] = {other.slots[i].tag, n};
+                            ++count;
+                        }
+                } catch (...) {
+                    clear();
+                    throw;
+                }
+                return [this, &other](node const* n) noexcept { return slots[other.slot_of(n)].n; };
+            }
+
+            // Returns null if k is already present.
+            template <typename KK, typename VV>
+            node* try_emplace_back(KK&& k, VV&& v) {                           // strong guarantee
+                size_t tag = tag_of(k);
+                if (lookup(tag, k))
+                    return nullptr;
+                return add(tag, std::forward<KK>(k), std::forward<VV>(v));
+            }
+
+            // Builds the key and the value from the elements of the tuples.
+            // Returns null if the key is already present.
+            template <typename KT, typename VT>
+            node* try_emplace_piecewise(KT&& key_args, VT&& value_args) {      // strong guarantee
+                reserve(count + 1);
+                node* n = make_node(std::forward<KT>(key_args), std::forward<VT>(value_args));
+                size_t tag;
+                try {
+                    tag = tag_of(n->key);
+                    if (lookup(tag, n->key)) {
+                        destroy(n);
+                        return nullptr;
+                    }
+                } catch (...) {
+                    destroy(n);
+                    throw;
+                }
+                link(tag, n);
+                return n;
+            }
+
+            // Whether adopt neither allocates nor throws. Nodes keep their
+            // tags, so Hash and KeyEqual are not called.
+            static constexpr bool nothrow_transfer = std::allocator_traits<Alloc>::is_always_equal::value;
+
+            // Takes over the node n of from, whose key must be absent here.
+            // The node is relinked, not copied; room for it must be reserved.
+            void adopt(index& from, node* n) noexcept {
+                from.detach(n);
+                link(n->tag, n);
+            }
+
+            void erase(node* n) noexcept {
+                detach(n);
+                destroy(n);
+            }
+
+            void reserve(size_t n) {                                            // strong guarantee
+                if (n * 4 <= slots.size() * 3)
+                    return;
+
+                size_t capacity = slots.empty() ? min_capacity : slots.size();
+                while (n * 4 > capacity * 3)
+                    capacity *= 2;
+
+                slots_vector old(capacity, slots.get_allocator());
+                old.swap(slots);
+                for (slot const& s : old)
+                    if (s.tag != 0)
+                        place(s);
+            }
+
+            void clear() noexcept {
+                for (slot const& s : slots)
+                    if (s.n)
+                        destroy(s.n);
+                slots.clear();
+                count = 0;
+            }
+
+            void forget() noexcept {
+                auto slots_alloc = slots.get_allocator();
+                ::new (static_cast<void*>(&slots)) slots_vector(slots_alloc);
+                count = 0;
+            }
+        };
+    };
+
+    // Direct-address index for integral keys of at most 2 bytes: a table
+    // with a node pointer for every possible key, allocated by the first
+    // insertion (256 pointers for 1-byte keys, 65536 for 2-byte ones), so a
+    // lookup is a single load and never compares keys.
+    struct direct_index : detail::index_policy {
+        static constexpr bool ordered = false;
+
+        template <typename K>
+        using key_equal = std::equal_to<K>;
+
+        template <typename K, typename Q>
+        static constexpr bool transparent_for = false;
+
+        template <typename K, typename V, typename Alloc = std::allocator<std::byte>,
+                  template <typename, typename> class Body = detail::note_body>
+        class index {
+            static_assert(std::is_integral_v<K> && sizeof(K) <= 2,
+                          "direct_index needs integral keys of at most 2 bytes");
+
+        public:
+            struct node;
+            using body_type = Body<node, V>;
+
+            struct node : body_type {
+                K key;
+
+                template <typename KT, typename VT>
+                node(KT&& key_args, VT&& value_args)
+                    : body_type(std::piecewise_construct, std::forward<VT>(value_args)),
+                      key(std::make_from_tuple<K>(std::forward<KT>(key_args))) {}
+            };
+
+        private:
+            static constexpr size_t table_size = size_t(1) << (8 * sizeof(K));
+
+            using node_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<node>;
+            using node_traits = std::allocator_traits<node_alloc>;
+            using table_vector = std::vector<node*, typename std::allocator_traits<Alloc>::template rebind_alloc<node*>>;
+
+            table_vector table;
+            [[no_unique_address]] node_alloc alloc;
+
+            static size_t slot_of(K k) noexcept { return static_cast<size_t>(k) & (table_size - 1); }
+
+            template <typename KT, typename VT>
+            node* make_node(KT&& key_args, VT&& value_args) {                  // strong guarantee
+                node* n = node_traits::allocate(alloc, 1);
+                try {
+                    node_traits::construct(alloc, n, std::forward<KT>(key_args), std::forward<VT>(value_args));
+                } catch (...) {
+                    node_traits::deallocate(alloc, n, 1);
+                    throw;
+                }
+                return n;
+            }
+
+            void destroy(node* n) noexcept {
+                node_traits::destroy(alloc, n);
+                node_traits::deallocate(alloc, n, 1);
+            }
+
+        public:
+            explicit index(Alloc const& alloc = Alloc()) : table(alloc), alloc(alloc) {}
+            index(index const&) = delete;
+            index& operator=(index const&) = delete;
+
+            ~index() {
+                clear();
+            }
+
+            static K const& key_of(node const* n) noexcept { return n->key; }
+            static body_type& body(node* n) noexcept { return *n; }
+            static body_type const& body(node const* n) noexcept { return *n; }
+
+            node* find(K const& k) const noexcept {
+                return table.empty() ? nullptr : table[slot_of(k)];
+            }
+
+            template <typename KK, typename VV>
+            node* emplace(KK&& k, VV&& v) {                                    // strong guarantee
+                reserve(1);
+                node* n = make_node(std::forward_as_tuple(std::forward<KK>(k)),
+                                    std::forward_as_tuple(std::forward<VV>(v)));
+                table[slot_of(n->key)] = n;
+                return n;
+            }
+
+            // Every copy takes the entry of its original.
+            auto clone_from(index const& other) {                               // strong guarantee
+                reserve(other.table.empty() ? 0 : 1);
+                try {
+                    for (size_t i = 0; i < other.table.size(); i++)
+                        if (node const* from = other.table[i]) {
+                            node* n = node_traits::allocate(alloc, 1);
+                            try {
+                                node_traits::construct(alloc, n, *from);
+                            } catch (...) {
+                                node_traits::deallocate(alloc, n, 1);
+                                throw;
+                            }
+                            table[i] = n;
+                        }
+                } catch (...) {
+                    clear();
+                    throw;
+                }
+                return [this](node const* n) noexcept { return table[slot_of(n->key)]; };
+            }
+
+            // Returns null if k is already present.
+            template <typename KK, typename VV>
+            node* try_emplace_back(KK&& k, VV&& v) {                           // strong guarantee
+                if (find(k))
+                    return nullptr;
+                return emplace(std::forward<KK>(k), std::forward<VV>(v));
+            }
+
+            // Builds the key and the value from the elements of the tuples.
+            // Returns null if the key is already present.
+            template <typename KT, typename VT>
+            node* try_emplace_piecewise(KT&& key_args, VT&& value_args) {      // strong guarantee
+                reserve(1);
+                node* n = make_node(std::forward<KT>(key_args), std::forward<VT>(value_args));
+                if (table[slot_of(n->key)]) {
+                    destroy(n);
+                    return nullptr;
+                }
+                table[slot_of(n->key)] = n;
+                return n;
+            }
+
+            // Whether adopt neither allocates nor throws.
+            static constexpr bool nothrow_transfer = std::allocator_traits<Alloc>::is_always_equal::value;
+
+            // Takes over the node n of from, whose key must be absent here.
+            // The node is relinked, not copied; room for it must be reserved.
+            void adopt(index& from, node* n) noexcept {
+                from.table[slot_of(n->key)] = nullptr;
+                table[slot_of(n->key)] = n;
+            }
+
+            void erase(node* n) noexcept {
+                table[slot_of(n->key)] = nullptr;
+                destroy(n);
+            }
+
+            void reserve(size_t n) {                                            // strong guarantee
+                if (n > 0 && table.empty())
+                    table.assign(table_size, nullptr);
+            }
+
+            void clear() noexcept {
+                for (node*& n : table)
+                    if (n) {
+                        destroy(n);
+                        n = nullptr;
+                    }
+            }
+
+            void forget() noexcept {
+                auto table_alloc = table.get_allocator();
+                ::new (static_cast<void*>(&table)) table_vector(table_alloc);
+            }
+        };
+    };
+
+    namespace detail {
+        // Hashes anything convertible to std::string_view, so std::string
+        // keys are found by views and C strings without building a string.
+        struct string_hash {
+            using is_transparent = void;
+
+            size_t operator()(std::string_view s) const noexcept {
+                return std::hash<std::string_view>{}(s);
+            }
+        };
+
+        template <typename K>
+        struct default_index {
+            using type = ordered_index<>;
+        };
+
+        template <typename K>
+            requires std::is_integral_v<K>
+        struct default_index<K> {
+            using type = hash_index<>;
+        };
+
+        template <>
+        struct default_index<std::string> {
+            using type = hash_index<string_hash, std::equal_to<>>;
+        };
+    }
+
+    // The index policy used when a binder names none: hash_index for
+    // integral keys and for std::string (with a transparent hash),
+    // ordered_index otherwise. direct_index is never picked by default: its
+    // table takes 2 KiB from the first insertion on (for 1-byte keys, 512
+    // KiB for 2-byte ones) and is copied whole by every unsharing clone,
+    // even of a binder with a single note.
+    template <typename K>
+    using default_index_t = typename detail::default_index<K>::type;
+}
+
+#endif //BINDER_INDEX_H
@@ -0,0 +1,377 @@
+#ifndef BINDER_PERSISTENT_H
+#define BINDER_PERSISTENT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "binder_allocator.h"
+#include "binder_detail.h"
+#include "binder_index.h"
+#include "binder_threading.h"
+
+namespace cxx {
+    // Structurally shared storage. Notes live in an immutable AVL tree ordered
+    // by the comparator of the ordered_index policy; insertion order is kept
+    // as prev/next key links inside the tree. Copying the storage shares the
+    // whole tree, and every write copies only the O(log n) nodes on the paths
+    // it touches, so unsharing a binder is O(1). Moving to the next note costs
+    // a key lookup, and any write invalidates iterators of the binder it is
+    // performed on.
+    struct persistent_storage : detail::storage_policy {
+        template <typename K, typename V, typename Policies>
+        class data {
+            using index_policy = detail::select_policy_t<detail::index_policy, ordered_index<>, Policies>;
+            static_assert(index_policy::ordered, "persistent_storage needs an ordered_index");
+            static_assert(std::is_same_v<detail::select_policy_t<detail::allocator_policy, default_allocator, Policies>,
+                                         default_allocator>,
+                          "persistent_storage shares nodes between copies and cannot use a per-copy arena");
+
+            using counter = typename detail::select_policy_t<detail::threading_policy, multi_threaded, Policies>::counter;
+
+            struct key_cell : detail::ref_counted<counter> {
+                K key;
+
+                template <typename Tuple>
+                key_cell(std::piecewise_construct_t, Tuple&& args)
+                    : key(std::make_from_tuple<K>(std::forward<Tuple>(args))) {}
+            };
+
+            struct value_cell : detail::ref_counted<counter> {
+                V value;
+
+                template <typename Tuple>
+                value_cell(std::piecewise_construct_t, Tuple&& args)
+                    : value(std::make_from_tuple<V>(std::forward<Tuple>(args))) {}
+            };
+
+            using key_ptr = detail::counted_ptr<key_cell>;
+            using value_ptr = detail::counted_ptr<value_cell>;
+
+            struct payload {
+                key_ptr key;
+                value_ptr value;
+                key_ptr prev;
+                key_ptr next;
+            };
+
+            struct node;
+            using node_ptr = detail::counted_ptr<node>;
+
+            struct node : detail::ref_counted<counter> {
+                node_ptr left;
+                node_ptr right;
+                payload p;
+                int height;
+
+                node(node_ptr l, payload const& p, node_ptr r) noexcept
+                    : left(std::move(l)), right(std::move(r)), p(p),
+                      height(std::max(data::height(left.get()), data::height(right.get())) + 1) {}
+            };
+
+            node_ptr root;
+            key_ptr head;
+            key_ptr tail;
+            size_t count = 0;
+
+            template <typename A, typename B>
+            static bool less(A const& a, B const& b) {
+                return typename index_policy::template compare<K>{}(a, b);
+            }
+
+            static K const& key_of(node const* t) noexcept {
+                return t->p.key->key;
+            }
+
+            template <typename KK>
+            static key_ptr make_key(KK&& k) {                                   // strong guarantee
+                return key_ptr::make(std::piecewise_construct, std::forward_as_tuple(std::forward<KK>(k)));
+            }
+
+            template <typename VV>
+            static value_ptr make_value(VV&& v) {                               // strong guarantee
+                return value_ptr::make(std::piecewise_construct, std::forward_as_tuple(std::forward<VV>(v)));
+            }
+
+            static int height(node const* t) noexcept {
+                return t ? t->height : 0;
+            }
+
+            static node_ptr create(node_ptr l, payload const& p, node_ptr r) {  // strong guarantee
+                return node_ptr::make(std::move(l), p, std::move(r));
+            }
+
+            // Builds a node whose subtrees differ in height by at most 3,
+            // restoring the invariant (difference at most 2) with rotations.
+            static node_ptr balance(node_ptr l, payload const& p, node_ptr r) {
+                int hl = height(l.get());
+                int hr = height(r.get());
+
+                if (hl > hr + 2) {
+                    node const* ln = l.get();
+                    if (height(ln->left.get()) >= height(ln->right.get()))
+                        return create(ln->left, ln->p, create(ln->right, p, std::move(r)));
+
+                    node const* lrn = ln->right.get();
+                    return create(create(ln->left, ln->p, lrn->left), lrn->p,
+                                  create(lrn->right, p, std::move(r)));
+                }
+
+                if (hr > hl + 2) {
+                    node const* rn = r.get();
+                    if (height(rn->right.get()) >= height(rn->left.get()))
+                        return create(create(std::move(l), p, rn->left), rn->p, rn->right);
+
+                    node const* rln = rn->left.get();
+                    return create(create(std::move(l), p, rln->left), rln->p,
+                                  create(rln->right, rn->p, rn->right));
+                }
+
+                return create(std::move(l), p, std::move(r));
+            }
+
+            // The key of p must not be present in t.
+            static node_ptr add(node const* t, payload const& p) {
+                if (!t)
+                    return create(nullptr, p, nullptr);
+
+                if (less(p.key->key, key_of(t)))
+                    return balance(add(t->left.get(), p), t->p, t->right);
+                return balance(t->left, t->p, add(t->right.get(), p));
+            }
+
+            static node const* min_node(node const* t) noexcept {
+                while (t->left)
+                    t = t->left.get();
+                return t;
+            }
+
+            static node_ptr remove_min(node const* t) {
+                if (!t->left)
+                    return t->right;
+                return balance(remove_min(t->left.get()), t->p, t->right);
+            }
+
+            static node_ptr merge(node_ptr const& l, node_ptr const& r) {
+                if (!l)
+                    return r;
+                if (!r)
+                    return l;
+                return balance(l, min_node(r.get())->p, remove_min(r.get()));
+            }
+
+            // The key k must be present in t.
+            static node_ptr remove(node const* t, K const& k) {
+                if (less(k, key_of(t)))
+                    return balance(remove(t->left.get(), k), t->p, t->right);
+                if (less(key_of(t), k))
+                    return balance(t->left, t->p, remove(t->right.get(), k));
+                return merge(t->left, t->right);
+            }
+
+            // Copies the path to the node with key k (which must be present)
+            // and applies f to the payload of the copy.
+            template <typename F>
+            static node_ptr update(node const* t, K const& k, F const& f) {
+                if (less(k, key_of(t)))
+                    return create(update(t->left.get(), k, f), t->p, t->right);
+                if (less(key_of(t), k))
+                    return create(t->left, t->p, update(t->right.get(), k, f));
+
+                payload p = t->p;
+                f(p);
+                return create(t->left, p, t->right);
+            }
+
+            template <typename Q>
+            static node const* find_in(node const* t, Q const& k) {
+                while (t) {
+                    if (less(k, key_of(t)))
+                        t = t->left.get();
+                    else if (less(key_of(t), k))
+                        t = t->right.get();
+                    else
+                        return t;
+                }
+                return nullptr;
+            }
+
+            static node_ptr detach_values(node const* t) {
+                if (!t)
+                    return nullptr;
+
+                payload p = t->p;
+                p.value = make_value(t->p.value->value);
+                return create(detach_values(t->left.get()), p, detach_values(t->right.get()));
+            }
+
+            node const* link_front(key_ptr key, value_ptr value) {              // strong guarantee
+                node_ptr new_root = root;
+                if (head)
+                    new_root = update(new_root.get(), head->key, [&](payload& p) { p.prev = key; });
+                new_root = add(new_root.get(), {key, value, nullptr, head});
+                node const* h = find_in(new_root.get(), key->key);
+
+                root = std::move(new_root);                                     // no-throw from here
+                if (!tail)
+                    tail = key;
+                head = std::move(key);
+                ++count;
+                return h;
+            }
+
+            node const* link_after(node const* position, key_ptr key, value_ptr value) {  // strong guarantee
+                key_ptr prev = position->p.key;
+                key_ptr next = position->p.next;
+
+                node_ptr new_root = update(root.get(), prev->key, [&](payload& p) { p.next = key; });
+                if (next)
+                    new_root = update(new_root.get(), next->key, [&](payload& p) { p.prev = key; });
+                new_root = add(new_root.get(), {key, value, prev, next});
+                node const* h = find_in(new_root.get(), key->key);
+
+                root = std::move(new_root);                                     // no-throw from here
+                if (!next)
+                    tail = std::move(key);
+                ++count;
+                return h;
+            }
+
+        public:
+            using handle = node const*;
+
+            template <typename Q>
+            static constexpr bool transparent_for = index_policy::template transparent_for<K, Q>;
+
+            data() = default;
+
+            data(data const& other) = default;
+
+            data(data const& other, detail::deep_copy_t)
+                : root(detach_values(other.root.get())), head(other.head), tail(other.tail),
+                  count(other.count) {}
+
+            size_t size() const noexcept { return count; }
+
+            handle end() const noexcept { return nullptr; }
+
+            handle begin() const {
+                return head ? find(head->key) : nullptr;
+            }
+
+            handle last() const {
+                return tail ? find(tail->key) : nullptr;
+            }
+
+            handle next(handle h) const {
+                return h->p.next ? find(h->p.next->key) : nullptr;
+            }
+
+            handle prev(handle h) const {
+                return h->p.prev ? find(h->p.prev->key) : nullptr;
+            }
+
+            template <typename Q>
+            handle find(Q const& k) const {
+                return find_in(root.get(), k);
+            }
+
+            K const& key(handle h) const noexcept { return key_of(h); }
+
+            V const& value(handle h) const noexcept { return h->p.value->value; }
+
+            V& value_for_write(handle h) {                                      // strong guarantee
+                K const& k = key_of(h);
+
+                node* t = root.get();
+                bool unique = root.unique();
+                while (unique && t != h) {
+                    node_ptr& child = less(k, key_of(t)) ? t->left : t->right;
+                    t = child.get();
+                    unique = child.unique();
+                }
+                if (unique && h->p.value.unique())
+                    return h->p.value->value;
+
+                value_ptr cell = make_value(h->p.value->value);
+                root = update(root.get(), k, [&](payload& p) { p.value = cell; });
+                return cell->value;
+            }
+
+            template <typename KK, typename VV>
+            handle insert_front(KK&& k, VV&& v) {                               // strong guarantee
+                key_ptr key = make_key(std::forward<KK>(k));
+                return link_front(std::move(key), make_value(std::forward<VV>(v)));
+            }
+
+            template <typename KK, typename VV>
+            handle insert_after(handle position, KK&& k, VV&& v) {              // strong guarantee
+                key_ptr key = make_key(std::forward<KK>(k));
+                return link_after(position, std::move(key), make_value(std::forward<VV>(v)));
+            }
+
+            // Inserts at the back; returns end() if k is already present.
+            template <typename KK, typename VV>
+            handle try_append(KK&& k, VV&& v) {                                 // strong guarantee
+                if (find(k))
+                    return end();
+                return tail ? insert_after(find(tail->key), std::forward<KK>(k), std::forward<VV>(v))
+                            : insert_front(std::forward<KK>(k), std::forward<VV>(v));
+            }
+
+            // Builds the key and the value from the elements of the tuples and
+            // inserts the note after position, or at the front if position is
+            // end(). Returns end() if the key is already present.
+            template <typename KT, typename VT>
+            handle try_emplace_after(handle position, KT&& key_args, VT&& value_args) { // strong guarantee
+                key_ptr key = key_ptr::make(std::piecewise_construct, std::forward<KT>(key_args));
+                if (find(key->key))
+                    return end();
+                value_ptr value = value_ptr::make(std::piecewise_construct, std::forward<VT>(value_args));
+                return position ? link_after(position, std::move(key), std::move(value))
+                                : link_front(std::move(key), std::move(value));
+            }
+
+            // Moves the note h after position, or to the front if position is
+            // end(). The key and value cells are reused, not copied.
+            void relink_after(handle position, handle h) {                      // strong guarantee
+                data moved(*this);
+                moved.erase(h);
+                if (position)
+                    moved.link_after(moved.find(key_of(position)), h->p.key, h->p.value);
+                else
+                    moved.link_front(h->p.key, h->p.value);
+                *this = moved;                                                  // no-throw
+            }
+
+            void erase(handle position) {                                       // strong guarantee
+                payload p = position->p;
+
+                node_ptr new_root = remove(root.get(), p.key->key);
+                if (p.prev)
+                    new_root = update(new_root.get(), p.prev->key, [&](payload& q) { q.next = p.next; });
+                if (p.next)
+                    new_root = update(new_root.get(), p.next->key, [&](payload& q) { q.prev = p.prev; });
+
+                root = std::move(new_root);                                     // no-throw from here
+                if (!p.prev)
+                    head = p.next;
+                if (!p.next)
+                    tail = p.prev;
+                --count;
+            }
+
+            void clear() noexcept {
+                root = nullptr;
+                head = nullptr;
+                tail = nullptr;
+                count = 0;
+            }
+        };
+    };
+}
+
+#endif //BINDER_PERSISTENT_H
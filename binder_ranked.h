@@ -0,0 +1,330 @@
+#ifndef BINDER_RANKED_H
+#define BINDER_RANKED_H
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "binder_allocator.h"
+#include "binder_detail.h"
+#include "binder_index.h"
+
+namespace cxx {
+    namespace detail {
+        // The part of a note owned by ranked_storage: its links in the treap
+        // and the size of its subtree.
+        template <typename Node, typename V>
+        struct ranked_body {
+            Node* parent = nullptr;
+            Node* left = nullptr;
+            Node* right = nullptr;
+            size_t size = 1;
+            std::uint32_t priority = 0;
+            V value;
+
+            template <typename Tuple>
+            ranked_body(std::piecewise_construct_t, Tuple&& args)
+                : value(std::make_from_tuple<V>(std::forward<Tuple>(args))) {}
+        };
+    }
+
+    // Storage with positional access. Notes are kept in insertion order in a
+    // treap (a binary tree balanced by random priorities) whose nodes know
+    // the size of their subtree, so the i-th note and the position of a note
+    // are found in O(log n) expected time. Like in list_storage, the nodes
+    // are allocated and found by the key index policy, one allocation per
+    // note, and unsharing copies every note.
+    struct ranked_storage : detail::storage_policy {
+        template <typename K, typename V, typename Policies>
+        class data {
+            using index_policy = detail::select_policy_t<detail::index_policy, default_index_t<K>, Policies>;
+            using allocator_policy = detail::select_policy_t<detail::allocator_policy, default_allocator, Policies>;
+            using arena_type = typename allocator_policy::arena;
+            using iters_map = typename index_policy::template index<K, V, typename allocator_policy::allocator_type,
+                                                                    detail::ranked_body>;
+            using node = typename iters_map::node;
+
+            // Nodes need no destructor calls, so the arena may drop them all at once.
+            static constexpr bool bulk_release = arena_type::bulk_release &&
+                std::is_trivially_destructible_v<K> && std::is_trivially_destructible_v<V>;
+
+            arena_type arena;
+            iters_map iters{arena.get()};
+            node* root = nullptr;
+            node* head = nullptr;
+            node* tail = nullptr;
+            std::uint32_t seed = 0x9e3779b9;
+
+            static auto& body(node* n) noexcept { return iters_map::body(n); }
+            static auto const& body(node const* n) noexcept { return iters_map::body(n); }
+
+            static size_t size_of(node const* n) noexcept { return n ? body(n).size : 0; }
+
+            static void update(node* n) noexcept {
+                body(n).size = size_of(body(n).left) + size_of(body(n).right) + 1;
+            }
+
+            static node* leftmost(node* n) noexcept {
+                while (body(n).left)
+                    n = body(n).left;
+                return n;
+            }
+
+            static node* rightmost(node* n) noexcept {
+                while (body(n).right)
+                    n = body(n).right;
+                return n;
+            }
+
+            // xorshift32
+            std::uint32_t random() noexcept {
+                seed ^= seed << 13;
+                seed ^= seed >> 17;
+                seed ^= seed << 5;
+                return seed;
+            }
+
+            // Puts c in place of n in the link from the parent of n (or root).
+            void replace_child(node* n, node* c) noexcept {
+                node* p = body(n).parent;
+                (p ? (body(p).left == n ? body(p).left : body(p).right) : root) = c;
+                if (c)
+                    body(c).parent = p;
+            }
+
+            // Moves n above its parent, keeping the order of the notes.
+            void rotate_up(node* n) noexcept {
+                node* p = body(n).parent;
+                replace_child(p, n);
+                node*& inner = body(p).left == n ? body(n).right : body(n).left;
+                (body(p).left == n ? body(p).left : body(p).right) = inner;
+                if (inner)
+                    body(inner).parent = p;
+                inner = p;
+                body(p).parent = n;
+                update(p);
+                update(n);
+            }
+
+            // Links n after position, or at the front if position is null.
+            void link_after(node* position, node* n) noexcept {
+                body(n).parent = body(n).left = body(n).right = nullptr;
+                body(n).size = 1;
+                body(n).priority = random();
+                if (!root) {
+                    root = head = tail = n;
+                    return;
+                }
+
+                node* p;
+                if (!position) {
+                    p = head;
+                    body(p).left = n;
+                    head = n;
+                } else if (!body(position).right) {
+                    p = position;
+                    body(p).right = n;
+                    if (position == tail)
+                        tail = n;
+                } else {
+                    p = leftmost(body(position).right);
+                    body(p).left = n;
+                }
+                body(n).parent = p;
+
+                for (; p; p = body(p).parent)
+                    ++body(p).size;
+                while (body(n).parent && body(body(n).parent).priority < body(n).priority)
+                    rotate_up(n);
+            }
+
+            void unlink(node* n) noexcept {
+                if (n == head)
+                    head = const_cast<node*>(next(n));
+                if (n == tail)
+                    tail = const_cast<node*>(prev(n));
+
+                while (body(n).left && body(n).right) {
+                    node* l = body(n).left;
+                    node* r = body(n).right;
+                    rotate_up(body(l).priority > body(r).priority ? l : r);
+                }
+
+                node* p = body(n).parent;
+                replace_child(n, body(n).left ? body(n).left : body(n).right);
+                for (; p; p = body(p).parent)
+                    --body(p).size;
+            }
+
+        public:
+            using handle = node const*;
+
+            template <typename Q>
+            static constexpr bool transparent_for = index_policy::template transparent_for<K, Q>;
+
+            // Whether notes can be moved to another storage of the same type
+            // without being copied and without throwing (see adopt_after).
+            static constexpr bool nothrow_adopt = iters_map::nothrow_transfer && !arena_type::bulk_release;
+
+            data() = default;
+
+            // The index is cloned along its structure; the copies keep the
+            // subtree sizes and priorities of the originals and get their links.
+            // The priority generator continues from the state of other.
+            data(data const& other) : seed(other.seed) {
+                auto copy_of = iters.clone_from(other.iters);
+                auto copy_link = [&](node const* n) { return n ? copy_of(n) : nullptr; };
+                for (node const* n = other.head; n; n = next(n)) {
+                    node* c = copy_of(n);
+                    body(c).parent = copy_link(body(n).parent);
+                    body(c).left = copy_link(body(n).left);
+                    body(c).right = copy_link(body(n).right);
+                }
+                root = copy_link(other.root);
+                head = copy_link(other.head);
+                tail = copy_link(other.tail);
+            }
+
+            data(data const& other, detail::deep_copy_t) : data(other) {}
+
+            ~data() {
+                if constexpr (bulk_release)
+                    iters.forget();
+            }
+
+            size_t size() const noexcept { return size_of(root); }
+
+            handle begin() const noexcept { return head; }
+            handle last() const noexcept { return tail; }
+            handle end() const noexcept { return nullptr; }
+
+            handle next(handle h) const noexcept {
+                if (body(h).right)
+                    return leftmost(body(h).right);
+                while (body(h).parent && body(body(h).parent).right == h)
+                    h = body(h).parent;
+                return body(h).parent;
+            }
+
+            handle prev(handle h) const noexcept {
+                if (body(h).left)
+                    return rightmost(body(h).left);
+                while (body(h).parent && body(body(h).parent).left == h)
+                    h = body(h).parent;
+                return body(h).parent;
+            }
+
+            // The note at position i, or end() if i >= size().
+            handle nth(size_t i) const noexcept {
+                node const* t = root;
+                while (t) {
+                    size_t l = size_of(body(t).left);
+                    if (i == l)
+                        return t;
+                    if (i < l) {
+                        t = body(t).left;
+                    } else {
+                        i -= l + 1;
+                        t = body(t).right;
+                    }
+                }
+                return nullptr;
+            }
+
+            size_t index_of(handle h) const noexcept {
+                size_t i = size_of(body(h).left);
+                for (; body(h).parent; h = body(h).parent)
+                    if (body(body(h).parent).right == h)
+                        i += size_of(body(body(h).parent).left) + 1;
+                return i;
+            }
+
+            template <typename Q>
+            handle find(Q const& k) const {
+                return iters.find(k);
+            }
+
+            K const& key(handle h) const noexcept { return iters_map::key_of(h); }
+
+            V const& value(handle h) const noexcept { return body(h).value; }
+
+            V& value_for_write(handle h) noexcept { return body(const_cast<node*>(h)).value; }
+
+            template <typename KK, typename VV>
+            handle insert_front(KK&& k, VV&& v) {
+                node* n = iters.emplace(std::forward<KK>(k), std::forward<VV>(v));  // strong guarantee
+                link_after(nullptr, n);
+                return n;
+            }
+
+            template <typename KK, typename VV>
+            handle insert_after(handle position, KK&& k, VV&& v) {
+                node* n = iters.emplace(std::forward<KK>(k), std::forward<VV>(v));  // strong guarantee
+                link_after(const_cast<node*>(position), n);
+                return n;
+            }
+
+            // Inserts at the back; returns end() if k is already present.
+            template <typename KK, typename VV>
+            handle try_append(KK&& k, VV&& v) {
+                node* n = iters.try_emplace_back(std::forward<KK>(k), std::forward<VV>(v)); // strong guarantee
+                if (n)
+                    link_after(tail, n);
+                return n;
+            }
+
+            // Builds the key and the value from the elements of the tuples and
+            // inserts the note after position, or at the front if position is
+            // end(). Returns end() if the key is already present.
+            template <typename KT, typename VT>
+            handle try_emplace_after(handle position, KT&& key_args, VT&& value_args) {
+                node* n = iters.try_emplace_piecewise(std::forward<KT>(key_args),   // strong guarantee
+                                                      std::forward<VT>(value_args));
+                if (n)
+                    link_after(const_cast<node*>(position), n);
+                return n;
+            }
+
+            // Moves the note h after position, or to the front if position is
+            // end(). The node stays where it is in the index.
+            void relink_after(handle position, handle h) noexcept {
+                node* n = const_cast<node*>(h);
+                unlink(n);
+                link_after(const_cast<node*>(position), n);
+            }
+
+            void reserve(size_t n) {                                            // strong guarantee
+                iters.reserve(n);
+            }
+
+            // Moves the note h of other after position, or to the front if
+            // position is end(). Room for it must have been reserved.
+            void adopt_after(handle position, data& other, handle h) noexcept requires nothrow_adopt {
+                node* n = const_cast<node*>(h);
+                other.unlink(n);
+                iters.adopt(other.iters, n);
+                link_after(const_cast<node*>(position), n);
+            }
+
+            void erase(handle position) noexcept {
+                node* n = const_cast<node*>(position);
+                unlink(n);                                                      // no-throw
+                iters.erase(n);                                                 // no-throw
+            }
+
+            void clear() noexcept {
+                if constexpr (bulk_release) {
+                    iters.forget();
+                    arena.release();
+                } else {
+                    iters.clear();
+                }
+                root = head = tail = nullptr;
+            }
+        };
+    };
+}
+
+#endif //BINDER_RANKED_H
@@ -0,0 +1,157 @@
+#ifndef BINDER_SHARED_H
+#define BINDER_SHARED_H
+
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+#include "binder_detail.h"
+#include "binder_threading.h"
+
+namespace cxx {
+    struct list_storage;
+
+    // Storage adapter holding every value in a reference-counted cell, so
+    // copies of the storage share the values. Unsharing a binder copies only
+    // the notes of Storage (keys, links and pointers to the cells), and a
+    // write copies the one value it touches if another storage still shares
+    // it. A value handed out for writing is marked as lent; a deep copy
+    // copies just the lent values. Values are reached through one more
+    // pointer, so reads and scans are slower than with Storage alone.
+    template <typename Storage = list_storage>
+    struct shared_values : detail::storage_policy {
+        template <typename K, typename V, typename Policies>
+        class data {
+            using threading_policy = detail::select_policy_t<detail::threading_policy, multi_threaded, Policies>;
+            using counter = typename threading_policy::counter;
+
+            struct value_cell : detail::ref_counted<counter> {
+                V value;
+                bool lent = false;
+
+                template <typename Tuple>
+                value_cell(std::piecewise_construct_t, Tuple&& args)
+                    : value(std::make_from_tuple<V>(std::forward<Tuple>(args))) {}
+            };
+
+            using value_ptr = detail::counted_ptr<value_cell>;
+            using inner_data = typename Storage::template data<K, value_ptr, Policies>;
+
+            inner_data notes;
+
+            template <typename Tuple>
+            static value_ptr make_value(Tuple&& args) {                         // strong guarantee
+                return value_ptr::make(std::piecewise_construct, std::forward<Tuple>(args));
+            }
+
+            static value_ptr copy_value(value_ptr const& cell) {                // strong guarantee
+                return make_value(std::forward_as_tuple(std::as_const(cell->value)));
+            }
+
+            static constexpr bool positional = requires (inner_data const& d, typename inner_data::handle h) {
+                d.nth(size_t());
+                d.index_of(h);
+            };
+
+        public:
+            using handle = typename inner_data::handle;
+
+            template <typename Q>
+            static constexpr bool transparent_for = inner_data::template transparent_for<Q>;
+
+            static constexpr bool nothrow_adopt = requires { requires inner_data::nothrow_adopt; };
+
+            data() = default;
+
+            data(data const& other) = default;
+
+            // Values that may still be written through a reference handed out
+            // by other are copied; the rest stay shared.
+            data(data const& other, detail::deep_copy_t) : notes(other.notes) {
+                for (handle h = notes.begin(); h != notes.end(); h = notes.next(h))
+                    if (notes.value(h)->lent)
+                        notes.value_for_write(h) = copy_value(notes.value(h));
+            }
+
+            size_t size() const noexcept { return notes.size(); }
+
+            handle begin() const noexcept(noexcept(notes.begin())) { return notes.begin(); }
+            handle last() const noexcept(noexcept(notes.last())) { return notes.last(); }
+            handle end() const noexcept { return notes.end(); }
+            handle next(handle h) const noexcept(noexcept(notes.next(h))) { return notes.next(h); }
+            handle prev(handle h) const noexcept(noexcept(notes.prev(h))) { return notes.prev(h); }
+
+            handle nth(size_t i) const noexcept requires positional { return notes.nth(i); }
+
+            size_t index_of(handle h) const noexcept requires positional { return notes.index_of(h); }
+
+            template <typename Q>
+            handle find(Q const& k) const {
+                return notes.find(k);
+            }
+
+            K const& key(handle h) const noexcept { return notes.key(h); }
+
+            V const& value(handle h) const noexcept { return notes.value(h)->value; }
+
+            // Copies the value first if it is shared with another storage.
+            V& value_for_write(handle h) {                                      // strong guarantee
+                value_ptr& cell = notes.value_for_write(h);
+                if (!cell.unique())
+                    cell = copy_value(cell);
+                cell->lent = true;
+                return cell->value;
+            }
+
+            template <typename KK, typename VV>
+            handle insert_front(KK&& k, VV&& v) {
+                return notes.insert_front(std::forward<KK>(k),                 // strong guarantee
+                                          make_value(std::forward_as_tuple(std::forward<VV>(v))));
+            }
+
+            template <typename KK, typename VV>
+            handle insert_after(handle position, KK&& k, VV&& v) {
+                return notes.insert_after(position, std::forward<KK>(k),       // strong guarantee
+                                          make_value(std::forward_as_tuple(std::forward<VV>(v))));
+            }
+
+            // Inserts at the back; returns end() if k is already present.
+            template <typename KK, typename VV>
+            handle try_append(KK&& k, VV&& v) {
+                return notes.try_append(std::forward<KK>(k),                   // strong guarantee
+                                        make_value(std::forward_as_tuple(std::forward<VV>(v))));
+            }
+
+            // Builds the key and the value from the elements of the tuples and
+            // inserts the note after position, or at the front if position is
+            // end(). Returns end() if the key is already present.
+            template <typename KT, typename VT>
+            handle try_emplace_after(handle position, KT&& key_args, VT&& value_args) {
+                return notes.try_emplace_after(position, std::forward<KT>(key_args), // strong guarantee
+                                               std::forward_as_tuple(make_value(std::forward<VT>(value_args))));
+            }
+
+            void relink_after(handle position, handle h) noexcept(noexcept(notes.relink_after(position, h))) {
+                notes.relink_after(position, h);                                // strong guarantee
+            }
+
+            void reserve(size_t n) requires nothrow_adopt {                     // strong guarantee
+                notes.reserve(n);
+            }
+
+            void adopt_after(handle position, data& other, handle h) noexcept requires nothrow_adopt {
+                notes.adopt_after(position, other.notes, h);
+            }
+
+            void erase(handle position) noexcept(noexcept(notes.erase(position))) {
+                notes.erase(position);
+            }
+
+            void clear() noexcept {
+                notes.clear();
+            }
+        };
+    };
+}
+
+#endif //BINDER_SHARED_H
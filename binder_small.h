@@ -0,0 +1,369 @@
+#ifndef BINDER_SMALL_H
+#define BINDER_SMALL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "binder_detail.h"
+#include "binder_index.h"
+
+namespace cxx {
+    struct list_storage;
+
+    // Storage for binders that mostly hold few notes. Up to N notes live in
+    // arrays inside the storage object, keys apart from values, and are
+    // found by a linear scan of the keys with the index policy's comparator
+    // (or KeyEqual), so a small binder costs a single allocation. The note
+    // that does not fit copies all notes into a Large storage, which serves
+    // every operation from then on; clear() returns to the arrays. Handles
+    // taken before the move stay valid. Positional access (nth, index_of) is
+    // available if Large provides it.
+    template <size_t N = 8, typename Large = list_storage>
+    struct small_storage : detail::storage_policy {
+        template <typename K, typename V, typename Policies>
+        class data {
+            static_assert(N > 0 && N < 255, "small_storage keeps 1 to 254 notes inline");
+
+            using index_policy = detail::select_policy_t<detail::index_policy, default_index_t<K>, Policies>;
+            using large_data = typename Large::template data<K, V, Policies>;
+            using large_handle = typename large_data::handle;
+            using link = std::uint8_t;
+
+            static constexpr link none = 255;
+            static constexpr link wrapped = 254;                               // marks a large handle
+
+            // The large storage, with the handles of the notes that were in
+            // the slots when it was made.
+            struct grown {
+                large_data d;
+                large_handle slots[N] = {};
+
+                grown() = default;
+                explicit grown(large_data const& other) : d(other) {}
+                grown(large_data const& other, detail::deep_copy_t) : d(other, detail::deep_copy) {}
+            };
+
+            static constexpr bool nothrow_steps =
+                noexcept(std::declval<large_data const&>().begin()) &&
+                noexcept(std::declval<large_data const&>().last()) &&
+                noexcept(std::declval<large_data const&>().next(std::declval<large_handle>())) &&
+                noexcept(std::declval<large_data const&>().prev(std::declval<large_handle>()));
+
+            static constexpr bool nothrow_erase =
+                noexcept(std::declval<large_data&>().erase(std::declval<large_handle>()));
+
+            static constexpr bool nothrow_relink =
+                noexcept(std::declval<large_data&>().relink_after(std::declval<large_handle>(),
+                                                                  std::declval<large_handle>()));
+
+            static constexpr bool positional = requires (large_data const& d, large_handle h) {
+                d.nth(size_t());
+                d.index_of(h);
+            };
+
+            static constexpr bool nothrow_write =
+                noexcept(std::declval<large_data&>().value_for_write(std::declval<large_handle>()));
+
+            alignas(K) std::byte keys[N * sizeof(K)];
+            alignas(V) std::byte values[N * sizeof(V)];
+            link prev_of[N];
+            link next_of[N];                                                    // also chains the free slots
+            link head = none;
+            link tail = none;
+            link free = 0;
+            link count = 0;
+            std::unique_ptr<grown> large;
+
+            K& key_at(link i) noexcept { return *std::launder(reinterpret_cast<K*>(keys + i * sizeof(K))); }
+
+            K const& key_at(link i) const noexcept {
+                return *std::launder(reinterpret_cast<K const*>(keys + i * sizeof(K)));
+            }
+
+            V& value_at(link i) noexcept { return *std::launder(reinterpret_cast<V*>(values + i * sizeof(V))); }
+
+            V const& value_at(link i) const noexcept {
+                return *std::launder(reinterpret_cast<V const*>(values + i * sizeof(V)));
+            }
+
+            template <typename Q>
+            static bool matches(K const& a, Q const& b) {
+                if constexpr (index_policy::ordered) {
+                    typename index_policy::template compare<K> less;
+                    return !less(a, b) && !less(b, a);
+                } else {
+                    return typename index_policy::template key_equal<K>{}(a, b);
+                }
+            }
+
+            // The slot with key k other than skip, or none.
+            template <typename Q>
+            link scan(Q const& k, link skip = none) const {
+                for (link i = head; i != none; i = next_of[i])
+                    if (i != skip && matches(key_at(i), k))
+                        return i;
+                return none;
+            }
+
+            void reset() noexcept {
+                for (size_t i = 0; i < N; i++)
+                    next_of[i] = i + 1 < N ? static_cast<link>(i + 1) : none;
+                head = tail = none;
+                free = 0;
+                count = 0;
+            }
+
+            // Builds a note in a free slot, which is not linked yet.
+            template <typename KT, typename VT>
+            link construct(KT&& key_args, VT&& value_args) {                   // strong guarantee
+                link i = free;
+                ::new (static_cast<void*>(keys + i * sizeof(K))) K(std::make_from_tuple<K>(std::forward<KT>(key_args)));
+                try {
+                    ::new (static_cast<void*>(values + i * sizeof(V)))
+                        V(std::make_from_tuple<V>(std::forward<VT>(value_args)));
+                } catch (...) {
+                    key_at(i).~K();
+                    throw;
+                }
+                free = next_of[i];
+                return i;
+            }
+
+            void destroy(link i) noexcept {
+                key_at(i).~K();
+                value_at(i).~V();
+                next_of[i] = free;
+                free = i;
+            }
+
+            void destroy_all() noexcept {
+                for (link i = head; i != none;) {
+                    link next = next_of[i];
+                    key_at(i).~K();
+                    value_at(i).~V();
+                    i = next;
+                }
+                reset();
+            }
+
+            // Links i after position, or at the front if position is none.
+            void link_after(link position, link i) noexcept {
+                prev_of[i] = position;
+                next_of[i] = position == none ? head : next_of[position];
+                (next_of[i] == none ? tail : prev_of[next_of[i]]) = i;
+                (position == none ? head : next_of[position]) = i;
+                ++count;
+            }
+
+            void unlink(link i) noexcept {
+                (prev_of[i] == none ? head : next_of[prev_of[i]]) = next_of[i];
+                (next_of[i] == none ? tail : prev_of[next_of[i]]) = prev_of[i];
+                --count;
+            }
+
+            void copy_notes(data const& other) {
+                for (link i = other.head; i != none; i = other.next_of[i])
+                    link_after(tail, construct(std::forward_as_tuple(other.key_at(i)),
+                                               std::forward_as_tuple(other.value_at(i))));
+            }
+
+            // Copies the notes into a new large storage.
+            void grow() {                                                       // strong guarantee
+                auto g = std::make_unique<grown>();
+                large_handle position = g->d.end();
+                for (link i = head; i != none; i = next_of[i])
+                    position = position == g->d.end() ? g->d.insert_front(key_at(i), value_at(i))
+                                                      : g->d.insert_after(position, key_at(i), value_at(i));
+                for (link i = head; i != none; i = next_of[i])
+                    g->slots[i] = g->d.find(key_at(i));
+
+                destroy_all();                                                  // no-throw from here
+                large = std::move(g);
+            }
+
+        public:
+            // A slot in the arrays, or a handle of the large storage. Handles
+            // compare equal if they refer to the same note, also when one was
+            // taken before the notes moved to the large storage.
+            struct handle {
+                data const* owner = nullptr;
+                link slot = none;
+                large_handle in_large{};
+
+                bool operator==(handle const& other) const noexcept {
+                    data const* d = owner ? owner : other.owner;
+                    if (d && d->large)
+                        return d->unwrap(*this) == d->unwrap(other);
+                    return slot == other.slot;
+                }
+            };
+
+        private:
+            handle at(link i) const noexcept { return {this, i}; }
+
+            handle wrap(large_handle h) const noexcept { return {this, wrapped, h}; }
+
+            large_handle unwrap(handle h) const noexcept {
+                return h.slot == wrapped ? h.in_large : h.slot == none ? large->d.end() : large->slots[h.slot];
+            }
+
+        public:
+            template <typename Q>
+            static constexpr bool transparent_for = index_policy::template transparent_for<K, Q>;
+
+            data() noexcept { reset(); }
+
+            data(data const& other) : data() {
+                if (other.large)
+                    large = std::make_unique<grown>(other.large->d);
+                else
+                    copy_notes(other);
+            }
+
+            data(data const& other, detail::deep_copy_t) : data() {
+                if (other.large)
+                    large = std::make_unique<grown>(other.large->d, detail::deep_copy);
+                else
+                    copy_notes(other);
+            }
+
+            ~data() {
+                destroy_all();
+            }
+
+            size_t size() const noexcept { return large ? large->d.size() : count; }
+
+            handle begin() const noexcept(nothrow_steps) { return large ? wrap(large->d.begin()) : at(head); }
+            handle last() const noexcept(nothrow_steps) { return large ? wrap(large->d.last()) : at(tail); }
+            handle end() const noexcept { return at(none); }
+
+            handle next(handle h) const noexcept(nothrow_steps) {
+                return large ? wrap(large->d.next(unwrap(h))) : at(next_of[h.slot]);
+            }
+
+            handle prev(handle h) const noexcept(nothrow_steps) {
+                return large ? wrap(large->d.prev(unwrap(h))) : at(prev_of[h.slot]);
+            }
+
+            // The arrays hold at most N notes, so they are walked.
+            handle nth(size_t i) const noexcept requires positional {
+                if (large)
+                    return wrap(large->d.nth(i));
+                link j = head;
+                for (; j != none && i > 0; i--)
+                    j = next_of[j];
+                return at(j);
+            }
+
+            size_t index_of(handle h) const noexcept requires positional {
+                if (large)
+                    return large->d.index_of(unwrap(h));
+                size_t i = 0;
+                for (link j = head; j != h.slot; j = next_of[j])
+                    i++;
+                return i;
+            }
+
+            template <typename Q>
+            handle find(Q const& k) const {
+                return large ? wrap(large->d.find(k)) : at(scan(k));
+            }
+
+            K const& key(handle h) const noexcept { return large ? large->d.key(unwrap(h)) : key_at(h.slot); }
+
+            V const& value(handle h) const noexcept {
+                return large ? large->d.value(unwrap(h)) : value_at(h.slot);
+            }
+
+            V& value_for_write(handle h) noexcept(nothrow_write) {
+                return large ? large->d.value_for_write(unwrap(h)) : value_at(h.slot);
+            }
+
+            template <typename KK, typename VV>
+            handle insert_front(KK&& k, VV&& v) {
+                return insert_after(end(), std::forward<KK>(k), std::forward<VV>(v));
+            }
+
+            template <typename KK, typename VV>
+            handle insert_after(handle position, KK&& k, VV&& v) {
+                if (!large && count == N)
+                    grow();                                                     // strong guarantee
+                if (large) {
+                    large_handle p = unwrap(position);
+                    return wrap(p == large->d.end()
+                                    ? large->d.insert_front(std::forward<KK>(k), std::forward<VV>(v))
+                                    : large->d.insert_after(p, std::forward<KK>(k), std::forward<VV>(v)));
+                }
+
+                link i = construct(std::forward_as_tuple(std::forward<KK>(k)),  // strong guarantee
+                                   std::forward_as_tuple(std::forward<VV>(v)));
+                link_after(position.slot, i);
+                return at(i);
+            }
+
+            // Inserts at the back; returns end() if k is already present.
+            template <typename KK, typename VV>
+            handle try_append(KK&& k, VV&& v) {
+                return try_emplace_after(last(), std::forward_as_tuple(std::forward<KK>(k)),
+                                         std::forward_as_tuple(std::forward<VV>(v)));
+            }
+
+            // Builds the key and the value from the elements of the tuples and
+            // inserts the note after position, or at the front if position is
+            // end(). Returns end() if the key is already present.
+            template <typename KT, typename VT>
+            handle try_emplace_after(handle position, KT&& key_args, VT&& value_args) {
+                if (!large && count == N)
+                    grow();                                                     // strong guarantee
+                if (large)
+                    return wrap(large->d.try_emplace_after(unwrap(position), std::forward<KT>(key_args),
+                                                           std::forward<VT>(value_args)));
+
+                link i = construct(std::forward<KT>(key_args), std::forward<VT>(value_args)); // strong guarantee
+                try {
+                    if (scan(key_at(i), i) != none) {
+                        destroy(i);
+                        return end();
+                    }
+                } catch (...) {
+                    destroy(i);
+                    throw;
+                }
+                link_after(position.slot, i);
+                return at(i);
+            }
+
+            // Moves the note h after position, or to the front if position is
+            // end(). The note stays in its slot.
+            void relink_after(handle position, handle h) noexcept(nothrow_relink) {
+                if (large) {
+                    large->d.relink_after(unwrap(position), unwrap(h));
+                    return;
+                }
+                unlink(h.slot);
+                link_after(position.slot, h.slot);
+            }
+
+            void erase(handle position) noexcept(nothrow_erase) {
+                if (large) {
+                    large->d.erase(unwrap(position));
+                    return;
+                }
+                unlink(position.slot);
+                destroy(position.slot);
+            }
+
+            void clear() noexcept {
+                destroy_all();
+                large.reset();
+            }
+        };
+    };
+}
+
+#endif //BINDER_SMALL_H
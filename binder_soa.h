@@ -0,0 +1,432 @@
+#ifndef BINDER_SOA_H
+#define BINDER_SOA_H
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BINDER_SOA_X86
+#endif
+
+#include "binder_allocator.h"
+#include "binder_detail.h"
+#include "binder_flat.h"
+#include "binder_index.h"
+
+namespace cxx {
+    namespace detail {
+        // The first i in [first, last) with keys[i] == k, or last.
+        template <typename K>
+        size_t scan_keys_scalar(K const* keys, size_t first, size_t last, K k) noexcept {
+            while (first < last && !(keys[first] == k))
+                ++first;
+            return first;
+        }
+
+#ifdef BINDER_SOA_X86
+        template <typename K>
+        __attribute__((target("avx2"))) size_t scan_keys_avx2(K const* keys, size_t first, size_t last,
+                                                              K k) noexcept {
+            constexpr size_t lanes = 32 / sizeof(K);
+            __m256i needle;
+            if constexpr (sizeof(K) == 1)
+                needle = _mm256_set1_epi8(static_cast<char>(k));
+            else if constexpr (sizeof(K) == 2)
+                needle = _mm256_set1_epi16(static_cast<short>(k));
+            else if constexpr (sizeof(K) == 4)
+                needle = _mm256_set1_epi32(static_cast<int>(k));
+            else
+                needle = _mm256_set1_epi64x(static_cast<long long>(k));
+
+            auto compare = [&](size_t i) __attribute__((target("avx2"))) {
+                __m256i block = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(keys + i));
+                __m256i equal;
+                if constexpr (sizeof(K) == 1)
+                    equal = _mm256_cmpeq_epi8(block, needle);
+                else if constexpr (sizeof(K) == 2)
+                    equal = _mm256_cmpeq_epi16(block, needle);
+                else if constexpr (sizeof(K) == 4)
+                    equal = _mm256_cmpeq_epi32(block, needle);
+                else
+                    equal = _mm256_cmpeq_epi64(block, needle);
+                return static_cast<std::uint64_t>(static_cast<unsigned>(_mm256_movemask_epi8(equal)));
+            };
+
+            // Two blocks per branch.
+            for (; first + 2 * lanes <= last; first += 2 * lanes)
+                if (std::uint64_t mask = compare(first) | compare(first + lanes) << 32)
+                    return first + static_cast<size_t>(__builtin_ctzll(mask)) / sizeof(K);
+            if (first + lanes <= last) {
+                if (std::uint64_t mask = compare(first))
+                    return first + static_cast<size_t>(__builtin_ctzll(mask)) / sizeof(K);
+                first += lanes;
+            }
+            return scan_keys_scalar(keys, first, last, k);
+        }
+
+        template <typename K>
+        __attribute__((target("sse2"))) size_t scan_keys_sse2(K const* keys, size_t first, size_t last,
+                                                              K k) noexcept {
+            static_assert(sizeof(K) <= 4);
+            constexpr size_t lanes = 16 / sizeof(K);
+            __m128i needle;
+            if constexpr (sizeof(K) == 1)
+                needle = _mm_set1_epi8(static_cast<char>(k));
+            else if constexpr (sizeof(K) == 2)
+                needle = _mm_set1_epi16(static_cast<short>(k));
+            else
+                needle = _mm_set1_epi32(static_cast<int>(k));
+
+            for (; first + lanes <= last; first += lanes) {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(keys + first));
+                __m128i equal;
+                if constexpr (sizeof(K) == 1)
+                    equal = _mm_cmpeq_epi8(block, needle);
+                else if constexpr (sizeof(K) == 2)
+                    equal = _mm_cmpeq_epi16(block, needle);
+                else
+                    equal = _mm_cmpeq_epi32(block, needle);
+                if (unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(equal)))
+                    return first + static_cast<size_t>(__builtin_ctz(mask)) / sizeof(K);
+            }
+            return scan_keys_scalar(keys, first, last, k);
+        }
+#endif
+
+        // scan_keys_scalar, compared 32 or 16 bytes at a time for integral
+        // keys if the processor supports AVX2 or SSE2 (checked once).
+        template <typename K>
+        size_t scan_keys(K const* keys, size_t first, size_t last, K k) noexcept {
+#ifdef BINDER_SOA_X86
+            if constexpr (std::is_integral_v<K>) {
+                static bool const avx2 = __builtin_cpu_supports("avx2");
+                static bool const sse2 = __builtin_cpu_supports("sse2");
+                if (avx2)
+                    return scan_keys_avx2(keys, first, last, k);
+                if constexpr (sizeof(K) <= 4)
+                    if (sse2)
+                        return scan_keys_sse2(keys, first, last, k);
+            }
+#endif
+            return scan_keys_scalar(keys, first, last, k);
+        }
+
+        // Open-addressing table of the slots of soa_storage by the hash of
+        // their keys, for storages too large to scan. An entry is a slot + 1,
+        // 0 if empty; the keys stay in the storage's key vector.
+        template <typename K, typename Alloc>
+        class slot_table {
+            std::vector<size_t, Alloc> entries;
+
+            static size_t hash_of(K const& k) noexcept { return mix_hash(std::hash<K>{}(k)); }
+
+            size_t mask() const noexcept { return entries.size() - 1; }
+
+        public:
+            static constexpr size_t none = ~size_t(0);
+
+            // A table with n entries, a power of two, or none.
+            explicit slot_table(Alloc const& alloc, size_t n = 0) : entries(n, 0, alloc) {}
+
+            bool empty() const noexcept { return entries.empty(); }
+
+            Alloc get_allocator() const noexcept { return entries.get_allocator(); }
+
+            // Copies the entries of other, keeping the allocator.
+            void assign(slot_table const& other) {                             // strong guarantee
+                entries.assign(other.entries.begin(), other.entries.end());
+            }
+
+            void swap(slot_table& other) noexcept { entries.swap(other.entries); }
+
+            // The slot with key k, or none.
+            size_t find(K const* keys, K const& k) const noexcept {
+                for (size_t j = hash_of(k) & mask(); entries[j] != 0; j = (j + 1) & mask())
+                    if (keys[entries[j] - 1] == k)
+                        return entries[j] - 1;
+                return none;
+            }
+
+            void insert(K const* keys, size_t i) noexcept {
+                size_t j = hash_of(keys[i]) & mask();
+                while (entries[j] != 0)
+                    j = (j + 1) & mask();
+                entries[j] = i + 1;
+            }
+
+            // Backward shift deletion keeps probe sequences without gaps.
+            void erase(K const* keys, size_t i) noexcept {
+                size_t j = hash_of(keys[i]) & mask();
+                while (entries[j] != i + 1)
+                    j = (j + 1) & mask();
+                for (size_t k = (j + 1) & mask(); entries[k] != 0; k = (k + 1) & mask()) {
+                    size_t home = hash_of(keys[entries[k] - 1]) & mask();
+                    if (((k - home) & mask()) >= ((k - j) & mask())) {
+                        entries[j] = entries[k];
+                        j = k;
+                    }
+                }
+                entries[j] = 0;
+            }
+
+            void clear() noexcept {
+                std::fill(entries.begin(), entries.end(), 0);
+            }
+        };
+    }
+
+    // Storage for arithmetic keys with the keys, the values and the order links
+    // in parallel vectors (structure of arrays). While the vectors have room
+    // for at most 32 notes, a key is found by comparing it with the whole key
+    // vector, using SIMD instructions for integral keys when the processor
+    // has them; larger storages keep an open-addressing table of slot numbers.
+    // Slots are managed as in flat_storage: a new note takes the slot at the
+    // back, removal leaves a tombstone, and a full vector is rebuilt in the
+    // order of the notes. Nothing refers to a slot by address, so when K and
+    // V are trivially copyable, unsharing copies the vectors as they are, in
+    // bulk. The index policy is ignored.
+    struct soa_storage : detail::storage_policy {
+        template <typename K, typename V, typename Policies>
+        class data : detail::slot_list {
+            static_assert(std::is_arithmetic_v<K>, "soa_storage needs arithmetic keys");
+
+            using allocator_policy = detail::select_policy_t<detail::allocator_policy, default_allocator, Policies>;
+            using allocator_type = typename allocator_policy::allocator_type;
+
+            template <typename T>
+            using vector_of = std::vector<T, typename std::allocator_traits<allocator_type>::template rebind_alloc<T>>;
+
+            static constexpr size_t min_capacity = 8;
+            static constexpr size_t scan_limit = 32;
+            static constexpr bool bulk_copy = std::is_trivially_copyable_v<std::optional<V>>;
+
+            using table_type = detail::slot_table<K, typename vector_of<size_t>::allocator_type>;
+
+            struct links {
+                size_t prev;
+                size_t next;
+            };
+
+            typename allocator_policy::arena arena;
+            // A tombstone has no value; its key is stale.
+            vector_of<K> keys{arena.get()};
+            vector_of<std::optional<V>> values{arena.get()};
+            vector_of<links> order{arena.get()};
+            // Empty while the room is scan_limit or less, and otherwise at
+            // least twice the room.
+            table_type table{arena.get()};
+            size_t room = 0;
+
+            // An empty table for vectors with the given room.
+            table_type make_table(size_t new_room) const {                     // strong guarantee
+                return table_type(table.get_allocator(), new_room <= scan_limit ? 0 : std::bit_ceil(2 * new_room));
+            }
+
+            // Reserves the same room in all three vectors.
+            static size_t reserve_all(vector_of<K>& k, vector_of<std::optional<V>>& v, vector_of<links>& o,
+                                      size_t n) {                                // strong guarantee
+                k.reserve(n);
+                v.reserve(n);
+                o.reserve(n);
+                return std::min({k.capacity(), v.capacity(), o.capacity()});
+            }
+
+            // Inserts a note with key k after position, or at the front if
+            // position is none, unless k is present (then none is returned).
+            template <typename VT>
+            size_t add(size_t position, K k, VT&& value_args) {
+                if (find(k) != none)
+                    return none;
+                if (keys.size() == room)
+                    return add_rebuilding(position, k, std::forward<VT>(value_args));
+
+                values.emplace_back();                                          // no-throw, the room is there
+                try {
+                    detail::build_slot_value(values.back(), std::forward<VT>(value_args));
+                } catch (...) {
+                    values.pop_back();
+                    throw;
+                }
+                keys.push_back(k);
+                order.push_back({none, none});
+                if (!table.empty())
+                    table.insert(keys.data(), keys.size() - 1);
+                link_after(order, position, keys.size() - 1);
+                return keys.size() - 1;
+            }
+
+            // Like add, but first moves the notes in their order to new
+            // vectors twice their number, dropping the tombstones. Values are
+            // moved if that cannot throw and copied otherwise, so a failure
+            // leaves the storage as it was.
+            template <typename VT>
+            size_t add_rebuilding(size_t position, K k, VT&& value_args) {
+                std::optional<V> value;
+                detail::build_slot_value(value, std::forward<VT>(value_args));  // strong guarantee
+
+                vector_of<K> new_keys(keys.get_allocator());
+                vector_of<std::optional<V>> new_values(values.get_allocator());
+                vector_of<links> new_order(order.get_allocator());
+                size_t new_room = reserve_all(new_keys, new_values, new_order,  // strong guarantee
+                                              std::max(min_capacity, 2 * (count + 1)));
+                table_type new_table = make_table(new_room);                    // strong guarantee
+
+                size_t p = none;
+                for (size_t i = head; i != none; i = order[i].next) {
+                    size_t j = new_keys.size();
+                    if (i == position)
+                        p = j;
+                    new_values.push_back(std::move_if_noexcept(values[i]));     // strong guarantee
+                    new_keys.push_back(keys[i]);
+                    new_order.push_back({j - 1, j + 1});
+                }
+                new_values.push_back(std::move_if_noexcept(value));
+                new_keys.push_back(k);
+                new_order.push_back({none, none});
+
+                keys.swap(new_keys);                                            // no-throw from here
+                values.swap(new_values);
+                order.swap(new_order);
+                table.swap(new_table);
+                room = new_room;
+                if (!table.empty())
+                    for (size_t i = 0; i < keys.size(); i++)
+                        table.insert(keys.data(), i);
+                link_rebuilt(order);
+                link_after(order, p, count);
+                return count - 1;
+            }
+
+        public:
+            using handle = size_t;
+
+            template <typename Q>
+            static constexpr bool transparent_for = false;
+
+            data() = default;
+
+            // Trivially copyable notes are copied with their slots, tombstones
+            // and table as they are; others are copied in their order.
+            data(data const& other) {
+                if constexpr (bulk_copy) {
+                    reserve_all(keys, values, order, other.room);
+                    keys.assign(other.keys.begin(), other.keys.end());
+                    values.assign(other.values.begin(), other.values.end());
+                    order.assign(other.order.begin(), other.order.end());
+                    table.assign(other.table);
+                    room = other.room;
+                    head = other.head;
+                    tail = other.tail;
+                    count = other.count;
+                } else {
+                    room = reserve_all(keys, values, order, other.count);
+                    table = make_table(room);
+                    for (size_t j = other.head; j != none; j = other.order[j].next) {
+                        values.emplace_back(other.values[j]);
+                        keys.push_back(other.keys[j]);
+                        order.push_back({none, none});
+                        if (!table.empty())
+                            table.insert(keys.data(), keys.size() - 1);
+                        link_after(order, tail, keys.size() - 1);
+                    }
+                }
+            }
+
+            data(data const& other, detail::deep_copy_t) : data(other) {}
+
+            size_t size() const noexcept { return count; }
+
+            handle begin() const noexcept { return head; }
+            handle last() const noexcept { return tail; }
+            handle end() const noexcept { return none; }
+            handle next(handle h) const noexcept { return order[h].next; }
+            handle prev(handle h) const noexcept { return order[h].prev; }
+
+            // Without a table, the first live slot with key k; a match with a
+            // tombstone goes on.
+            handle find(K const& k) const noexcept {
+                if (!table.empty())
+                    return table.find(keys.data(), k);
+
+                for (size_t i = 0;; i++) {
+                    i = detail::scan_keys(keys.data(), i, keys.size(), k);
+                    if (i == keys.size())
+                        return none;
+                    if (values[i])
+                        return i;
+                }
+            }
+
+            K const& key(handle h) const noexcept { return keys[h]; }
+
+            V const& value(handle h) const noexcept { return *values[h]; }
+
+            V& value_for_write(handle h) noexcept { return *values[h]; }
+
+            template <typename KK, typename VV>
+            handle insert_front(KK&& k, VV&& v) {
+                return insert_after(none, std::forward<KK>(k), std::forward<VV>(v));
+            }
+
+            template <typename KK, typename VV>
+            handle insert_after(handle position, KK&& k, VV&& v) {
+                return add(position, k, std::forward_as_tuple(std::forward<VV>(v)));
+            }
+
+            // Inserts at the back; returns end() if k is already present.
+            template <typename KK, typename VV>
+            handle try_append(KK&& k, VV&& v) {
+                return add(tail, k, std::forward_as_tuple(std::forward<VV>(v)));
+            }
+
+            // Builds the key and the value from the elements of the tuples and
+            // inserts the note after position, or at the front if position is
+            // end(). Returns end() if the key is already present.
+            template <typename KT, typename VT>
+            handle try_emplace_after(handle position, KT&& key_args, VT&& value_args) {
+                return add(position, std::make_from_tuple<K>(std::forward<KT>(key_args)),
+                           std::forward<VT>(value_args));
+            }
+
+            // Moves the note h after position, or to the front if position is
+            // end(). The note stays in its slot.
+            void relink_after(handle position, handle h) noexcept {
+                unlink(order, h);
+                link_after(order, position, h);
+            }
+
+            // Leaves a tombstone, or shrinks the vectors if h is at their back.
+            void erase(handle position) noexcept {
+                unlink(order, position);
+                if (!table.empty())
+                    table.erase(keys.data(), position);
+                values[position].reset();
+                while (!values.empty() && !values.back()) {
+                    values.pop_back();
+                    keys.pop_back();
+                    order.pop_back();
+                }
+            }
+
+            void clear() noexcept {
+                keys.clear();
+                values.clear();
+                order.clear();
+                table.clear();
+                reset();
+            }
+        };
+    };
+}
+
+#endif //BINDER_SOA_H
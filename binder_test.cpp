@@ -7,14 +7,20 @@
 #include <cstddef>
 #include <cstdlib>
 #include <algorithm>
+#include <atomic>
 #include <iterator>
 #include <iostream>
+#include <limits>
+#include <memory_resource>
+#include <mutex>
 #include <new>
+#include <ranges>
 #include <stdexcept>
 #include <utility>
 #include <vector>
 #include <string>
 #include <string_view>
+#include <thread>
 
 using cxx::binder;
 
@@ -37,23 +43,23 @@ int main();
 
 namespace {
 #if TEST_NUM == 102 || TEST_NUM == 105 || TEST_NUM == 402 || TEST_NUM == 403 || \
-    (TEST_NUM > 500 && TEST_NUM <= 599) || TEST_NUM == 603
+    (TEST_NUM > 500 && TEST_NUM <= 599) || TEST_NUM == 603 || TEST_NUM > 700
   // Sprawdzamy równość (notatek) skoroszytów.
   // To wymaga poprawnego działania części metod oraz iteratora.
   // Sprawdzenie zakładek jest utrudnione przez brak bezpośredniego dostępu
-  template <typename K, typename V>
-  bool operator==(binder<K, V> const &b1, binder<K, V> const &b2) {
+  template <typename K, typename V, typename... P>
+  bool operator==(binder<K, V, P...> const &b1, binder<K, V, P...> const &b2) {
     size_t b1_size = b1.size();
     size_t b2_size = b2.size();
 
     if (b1_size != b2_size)
       return false;
 
-    binder<K, V> local1 = b1;
-    binder<K, V> local2 = b2;
+    binder<K, V, P...> local1 = b1;
+    binder<K, V, P...> local2 = b2;
 
-    typename binder<K, V>::const_iterator it1 = b1.cbegin(), end1 = b1.cend(),
-                                         it2 = b2.cbegin(), end2 = b2.cend();
+    typename binder<K, V, P...>::const_iterator it1 = b1.cbegin(), end1 = b1.cend(),
+                                                it2 = b2.cbegin(), end2 = b2.cend();
     for (; it1 != end1 && it2 != end2; ++it1, ++it2) {
       if (*it1 != *it2)
         return false;
@@ -128,10 +134,11 @@ namespace {
   }
 #endif
 
-#if TEST_NUM == 103 || TEST_NUM == 107 || TEST_NUM == 701
+#if TEST_NUM == 103 || TEST_NUM == 107 || TEST_NUM == 701 || TEST_NUM == 704 || TEST_NUM == 710 || \
+    TEST_NUM == 712
   // Potwierdzenie, że notatka o podanej zakładce nie znajduje się w skoroszycie.
-  template <typename K, typename V>
-  void assert_not_in(binder<K, V> const &bi, K const &k) {
+  template <typename K, typename V, typename... P>
+  void assert_not_in(binder<K, V, P...> const &bi, K const &k) {
     bool catched = false;
     try {
       as_const(bi).read(k);
@@ -218,9 +225,17 @@ namespace {
   }
 #endif
 
+#if TEST_NUM == 706 || TEST_NUM == 715 || TEST_NUM == 719 || TEST_NUM == 721 || TEST_NUM == 722 || \
+    TEST_NUM == 726 || TEST_NUM == 727 || TEST_NUM == 729
+  size_t allocation_count = 0;
+#endif
+
 #if TEST_NUM == 104 || TEST_NUM == 201 || TEST_NUM == 202 || TEST_NUM > 400
   class Key {
     friend int ::main();
+#if TEST_NUM > 700
+    friend struct KeyHash;
+#endif
 
   public:
     explicit Key(size_t key = 0) : key(key) {
@@ -238,6 +253,7 @@ namespace {
 
     Key(Key &&other) {
       key = other.key;
+      ++instance_count;
       ++operation_count;
     }
 
@@ -272,6 +288,15 @@ namespace {
   };
 #endif
 
+#if TEST_NUM > 700
+  struct KeyHash {
+    size_t operator()(Key const &k) const {
+      ThisCanThrow();
+      return k.key;
+    }
+  };
+#endif
+
 #if TEST_NUM == 104 || TEST_NUM == 106 || TEST_NUM == 201 || TEST_NUM == 202 || TEST_NUM > 400
   class Value {
     friend int ::main();
@@ -303,7 +328,7 @@ namespace {
     Value & operator=(Value const &other) = delete;
     Value & operator=(Value &&other) = delete;
 
-#if TEST_NUM > 400 && TEST_NUM <= 599
+#if (TEST_NUM > 400 && TEST_NUM <= 599) || TEST_NUM > 700
   public:
     auto operator<=>(Value const &other) const {
       ++operation_count;
@@ -335,7 +360,9 @@ namespace {
   }
 #endif
 
-#if TEST_NUM > 500 && TEST_NUM <= 599
+#if (TEST_NUM > 500 && TEST_NUM <= 599) || TEST_NUM == 703 || TEST_NUM == 705 || TEST_NUM == 708 || \
+    TEST_NUM == 717 || TEST_NUM == 722 || TEST_NUM == 723 || TEST_NUM == 724 || TEST_NUM == 725 || \
+    TEST_NUM == 726 || TEST_NUM == 729
   template <typename binder, typename Operation>
   bool StrongCheck(binder &b, binder const &d, Operation const &op, char const *name) {
     bool succeeded = false;
@@ -358,12 +385,994 @@ namespace {
     return succeeded;
   }
 #endif
+
+#if TEST_NUM > 700 && TEST_NUM <= 799
+  // Porównujemy skoroszyt z modelem: listą par (zakładka, notatka) w kolejności notatek.
+  template <typename B, typename K, typename V>
+  bool matches_model(B const &b, vector<pair<K, V>> const &model) {
+    if (b.size() != model.size())
+      return false;
+
+    auto it = b.cbegin();
+    for (auto const &[k, v] : model) {
+      if (it == b.cend() || !(*it == v) || !(b.read(k) == v))
+        return false;
+      ++it;
+    }
+    return it == b.cend();
+  }
+
+  // Wykonujemy losowy ciąg operacji jednocześnie na skoroszycie i na modelu.
+  // Zapamiętane kopie skoroszytu nie mogą się zmieniać.
+  template <typename B>
+  void random_operations_test(unsigned seed, int steps, int max_size) {
+    using model_t = vector<pair<int, int>>;
+
+    B b;
+    model_t model;
+    vector<pair<B, model_t>> copies;
+    int next_key = 0;
+
+    auto random = [&seed](size_t n) {
+      seed = seed * 1103515245u + 12345u;
+      return static_cast<size_t>((seed >> 8) % n);
+    };
+    auto position_of = [&model](int k) {
+      return std::find_if(model.begin(), model.end(), [k](auto const &p) {return p.first == k;});
+    };
+
+    for (int step = 0; step < steps; step++) {
+      size_t op = random(10);
+      if (model.size() >= static_cast<size_t>(max_size) && op < 3)
+        op = 3;
+
+      if (op == 0 || model.empty()) {
+        b.insert_front(next_key, step);
+        model.insert(model.begin(), {next_key++, step});
+      }
+      else if (op <= 2) {
+        int prev_k = model[random(model.size())].first;
+        b.insert_after(prev_k, next_key, step);
+        model.insert(position_of(prev_k) + 1, {next_key++, step});
+      }
+      else if (op == 3) {
+        b.remove();
+        model.erase(model.begin());
+      }
+      else if (op == 4) {
+        int k = model[random(model.size())].first;
+        b.remove(k);
+        model.erase(position_of(k));
+      }
+      else if (op == 5) {
+        int k = model[random(model.size())].first;
+        b.read(k) += 1000;
+        position_of(k)->second += 1000;
+      }
+      else if (op == 6) {
+        copies.push_back({b, model});
+      }
+      else if (op == 7) {
+        bool catched = false;
+        try {
+          b.insert_after(next_key + 1, next_key, 0);
+        }
+        catch (invalid_argument const &) {
+          catched = true;
+        }
+        assert(catched);
+      }
+      else if (op == 8) {
+        int k = model[random(model.size())].first;
+        bool catched = false;
+        try {
+          b.insert_front(k, 0);
+        }
+        catch (invalid_argument const &) {
+          catched = true;
+        }
+        assert(catched);
+      }
+      else if (random(20) == 0) {
+        b.clear();
+        model.clear();
+      }
+
+      assert(matches_model(b, model));
+    }
+
+    for (auto const &[copy, copy_model] : copies)
+      assert(matches_model(copy, copy_model));
+  }
+#endif
+
+#if TEST_NUM == 703 || TEST_NUM == 705 || TEST_NUM == 708 || TEST_NUM == 717 || TEST_NUM == 722 || \
+    TEST_NUM == 723 || TEST_NUM == 724 || TEST_NUM == 725 || TEST_NUM == 726 || TEST_NUM == 729
+  // Sprawdzamy silne gwarancje podstawowych operacji na skoroszycie typu B,
+  // także gdy skoroszyt współdzieli dane z kopią. Notatki (co najmniej 21)
+  // tworzy main, bo konstruktor klasy Value jest prywatny. Zakładki są typu K.
+  template <typename B, typename K = Key>
+  void strong_operations_test(vector<Value> const &values) {
+    bool success = false;
+    int trials;
+
+    for (trials = 1; !success; trials++) {
+      success = true;
+
+      B b, d;
+      vector<K> k;
+      for (size_t i = 0; i < 40; i++)
+        k.push_back(K(i));
+      Value const &v = values[20];
+
+      for (size_t i = 0; i < 20; i++) {
+        b.insert_front(k[i], values[i]);
+        d.insert_front(k[i], values[i]);
+      }
+      B shared(b);
+
+      auto check = [&](auto const &op, char const *name) {
+        throw_countdown = trials;
+        bool result = StrongCheck(b, d, op, name);
+        if (result)
+          op(d);
+        success &= result;
+      };
+
+      check([&](auto &b) {b.insert_front(k[30], v);}, "insert_front");
+      check([&](auto &b) {b.insert_after(k[10], k[31], v);}, "insert_after");
+      check([&](auto &b) {b.insert_after(k[0], k[32], v);}, "insert_after");
+      check([&](auto &b) {b.remove();}, "remove");
+      check([&](auto &b) {b.remove(k[5]);}, "remove(k)");
+      check([&](auto &b) {b.remove(k[19]);}, "remove(k)");
+      check([&](auto &b) {[[maybe_unused]] auto &r = b.read(k[7]);}, "read(k)");
+
+      pair<K, Value> front_batch[] = {{k[33], v}, {k[34], v}, {k[35], v}};
+      pair<K, Value> after_batch[] = {{k[36], v}, {k[37], v}};
+      check([&](auto &b) {b.insert_range_front(std::begin(front_batch), std::end(front_batch));},
+            "insert_range_front");
+      check([&](auto &b) {b.insert_range_after(k[12], std::begin(after_batch), std::end(after_batch));},
+            "insert_range_after");
+      check([&](auto &b) {
+        b.emplace_front(std::piecewise_construct, std::forward_as_tuple(38), std::forward_as_tuple(v));
+      }, "emplace_front");
+      check([&](auto &b) {
+        b.emplace_after(k[14], std::piecewise_construct, std::forward_as_tuple(39), std::forward_as_tuple(v));
+      }, "emplace_after");
+      check([&](auto &b) {assert(b.try_insert_front(k[21], v) == cxx::binder_status::ok);},
+            "try_insert_front");
+      check([&](auto &b) {assert(b.try_insert_after(k[2], k[22], v) == cxx::binder_status::ok);},
+            "try_insert_after");
+      check([&](auto &b) {assert(b.try_insert_after(k[2], k[4], v) == cxx::binder_status::key_exists);},
+            "try_insert_after");
+      check([&](auto &b) {assert(b.try_insert_after(k[29], k[23], v) == cxx::binder_status::key_not_found);},
+            "try_insert_after");
+      check([&](auto &b) {assert(b.try_remove(k[3]) == cxx::binder_status::ok);}, "try_remove(k)");
+      check([&](auto &b) {assert(b.try_remove(k[3]) == cxx::binder_status::key_not_found);},
+            "try_remove(k)");
+      check([&](auto &b) {assert(b.find(k[8]) != nullptr);}, "find(k)");
+      check([&](auto &b) {b.move_front(k[15]);}, "move_front");
+      check([&](auto &b) {b.move_after(k[1], k[16]);}, "move_after");
+      check([&](auto &b) {b.move_after(k[16], k[16]);}, "move_after");
+      check([&](auto &b) {b.move_back(k[2]);}, "move_back");
+      if constexpr (requires {b.nth(0);}) {
+        check([&](auto &b) {b.insert_at(5, k[24], v);}, "insert_at");
+        check([&](auto &b) {b.insert_at(0, k[25], v);}, "insert_at");
+        check([&](auto &b) {[[maybe_unused]] auto &r = b.nth(9);}, "nth");
+      }
+      check([&](auto &b) {
+        B o;
+        o.insert_front(k[26], v);
+        b.splice_after(k[6], std::move(o));
+      }, "splice_after");
+      check([&](auto &b) {
+        B o;
+        o.insert_front(k[27], v);
+        o.insert_front(k[28], v);
+        b.splice_front(std::move(o));
+      }, "splice_front");
+      check([&](auto &b) {[[maybe_unused]] B t = b.split_after(k[17]);}, "split_after");
+
+      assert(b == d);
+      assert(shared.size() == 20);
+    }
+
+    clog << "Liczba prób: " << trials << "\n";
+  }
+#endif
+
+#if TEST_NUM == 710
+  // Wątki kopiują wspólny skoroszyt, modyfikują swoje kopie i przekazują je
+  // sobie nawzajem, gdy wciąż współdzielą dane z kopią, którą wątek dalej modyfikuje.
+  template <typename B>
+  void concurrent_test(int threads, int rounds) {
+    B base;
+    for (int i = 0; i < 100; i++)
+      base.insert_front(i, i);
+
+    std::mutex mutex;
+    vector<B> mailbox;
+
+    auto worker = [&](int id) {
+      for (int r = 0; r < rounds; r++) {
+        B mine(base);
+        mine.insert_front(1000 + id, r);
+        mine.read(5) += 1;
+        mine.remove(0);
+
+        B handed(mine);
+        B taken;
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          mailbox.push_back(handed);
+          if (mailbox.size() > static_cast<size_t>(threads)) {
+            taken = mailbox.front();
+            mailbox.erase(mailbox.begin());
+          }
+        }
+        handed.clear();
+
+        mine.insert_after(1, 2000 + id, r);
+        mine.remove(5);
+        assert(mine.size() == 100);
+        assert(as_const(mine).read(2000 + id) == r);
+        assert(as_const(mine).read(1000 + id) == r);
+
+        if (taken.size() != 0) {
+          assert(taken.size() == 100);
+          assert(as_const(taken).read(5) == 6);
+          assert_not_in(taken, 0);
+          taken.remove(5);
+          taken.read(7) = -7;
+          assert(taken.size() == 99);
+        }
+      }
+    };
+
+    vector<std::thread> pool;
+    for (int id = 0; id < threads; id++)
+      pool.emplace_back(worker, id);
+    for (auto &t : pool)
+      t.join();
+
+    assert(base.size() == 100);
+    int i = 99;
+    for (auto it = base.cbegin(); it != base.cend(); ++it)
+      assert(*it == i--);
+    for (auto const &b : mailbox) {
+      assert(b.size() == 100);
+      assert(as_const(b).read(5) == 6);
+    }
+  }
+#endif
+
+#if TEST_NUM == 711
+  // Pisarz dopisuje notatki na końcu i usuwa je z początku, publikując po
+  // każdej operacji migawkę. Czytelnicy sprawdzają, że każda migawka zawiera
+  // spójną wersję: kolejne liczby, których jest tyle, ile podaje size().
+  template <typename B>
+  void snapshot_readers_test(int readers, int steps) {
+    using snapshot_t = typename B::snapshot_type;
+
+    B b;
+    b.insert_front(0, 0);
+    int first = 0, last = 0;
+
+    std::mutex mutex;
+    snapshot_t published = b.snapshot();
+    std::atomic<bool> done{false};
+
+    auto reader = [&] {
+      size_t scans = 0;
+      while (!done || scans == 0) {
+        snapshot_t s;
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          s = published;
+        }
+
+        size_t n = 0;
+        int expected = s.size() == 0 ? 0 : *s.cbegin();
+        for (auto it = s.cbegin(); it != s.cend(); ++it, ++n)
+          assert(*it == expected++);
+        assert(n == s.size());
+        if (n > 0)
+          assert(s.read(expected - 1) == expected - 1);
+        ++scans;
+      }
+    };
+
+    vector<std::thread> pool;
+    for (int i = 0; i < readers; i++)
+      pool.emplace_back(reader);
+
+    for (int step = 0; step < steps; step++) {
+      if (step % 3 != 2 || first == last) {
+        b.insert_after(last, last + 1, last + 1);
+        ++last;
+      }
+      else {
+        b.remove();
+        ++first;
+      }
+
+      snapshot_t s = b.snapshot();
+      std::lock_guard<std::mutex> lock(mutex);
+      published = s;
+    }
+    done = true;
+
+    for (auto &t : pool)
+      t.join();
+    assert(static_cast<int>(b.size()) == last - first + 1);
+  }
+#endif
+
+#if TEST_NUM == 714
+  // Notatka zliczająca kopie; przeniesienie kopią nie jest.
+  struct Payload {
+    inline static size_t copies = 0;
+
+    vector<char> data;
+
+    Payload(size_t n, char c) : data(n, c) {}
+
+    Payload(Payload const &other) : data(other.data) {
+      ++copies;
+    }
+
+    Payload(Payload &&other) noexcept = default;
+  };
+
+  // copies to liczba kopii notatek, gdy dwa razy przestaje być współdzielony
+  // skoroszyt z pięcioma notatkami.
+  template <typename B>
+  void emplace_test(size_t copies) {
+    B b;
+    b.emplace_front(std::piecewise_construct, std::forward_as_tuple(3, 'b'), std::forward_as_tuple(10, 'x'));
+    b.emplace_front(std::piecewise_construct, std::forward_as_tuple(3, 'a'), std::forward_as_tuple(20, 'y'));
+    b.emplace_after("bbb", std::piecewise_construct, std::forward_as_tuple("ccc"), std::forward_as_tuple(5, 'z'));
+
+    Payload p(1000, 'p');
+    string key(100, 'k');
+    b.insert_after("aaa", std::move(key), std::move(p));
+    assert(p.data.empty());
+
+    Payload q(7, 'q');
+    b.insert_front("ddd", std::move(q));
+
+    assert(b.size() == 5);
+    assert(Payload::copies == 0);
+
+    char const *order[] = {"ddd", "aaa", nullptr, "bbb", "ccc"};
+    size_t sizes[] = {7, 20, 1000, 10, 5};
+    size_t n = 0;
+    for (auto it = b.cbegin(); it != b.cend(); ++it, ++n) {
+      assert(it->data.size() == sizes[n]);
+      if (order[n])
+        assert(as_const(b).read(order[n]).data.size() == sizes[n]);
+    }
+    assert(as_const(b).read(string(100, 'k')).data[0] == 'p');
+
+    // Istniejąca zakładka: skoroszyt i jego kopia się nie zmieniają.
+    B copy(b);
+    bool catched = false;
+    try {
+      b.emplace_front(std::piecewise_construct, std::forward_as_tuple("aaa"), std::forward_as_tuple(1, 'e'));
+    }
+    catch (invalid_argument const &) {
+      catched = true;
+    }
+    assert(catched);
+
+    catched = false;
+    try {
+      b.emplace_after("xxx", std::piecewise_construct, std::forward_as_tuple("eee"), std::forward_as_tuple(1, 'e'));
+    }
+    catch (invalid_argument const &) {
+      catched = true;
+    }
+    assert(catched);
+    assert(b.size() == 5);
+    assert(copy.size() == 5);
+
+    // Nieudane emplace_front przestało już raz współdzielić skoroszyt.
+    b.remove("ddd");
+    assert(copy.size() == 5);
+    assert(Payload::copies == copies);
+    Payload::copies = 0;
+  }
+#endif
+
+#if TEST_NUM == 715
+  // Funkcja skrótu napisów przyjmująca każdy typ zamienialny na string_view.
+  struct StringHash {
+    using is_transparent = void;
+
+    size_t operator()(string_view s) const noexcept {
+      return std::hash<string_view>{}(s);
+    }
+  };
+
+  template <typename B>
+  concept reads_string_view = requires (B b, string_view k) { b.read(k); };
+
+  // Zakładka bez operatora <, uporządkowana specjalizacją std::less.
+  struct Version {
+    int number;
+    static inline size_t comparisons = 0;
+  };
+
+  template <typename B>
+  void specialized_less_test() {
+    B b;
+    b.insert_front(Version{1}, 1);
+    b.insert_after(Version{1}, Version{3}, 3);
+    b.insert_after(Version{1}, Version{2}, 2);
+    Version::comparisons = 0;
+    assert(b.read(Version{2}) == 2 && Version::comparisons > 0);
+    b.remove(Version{1});
+    int i = 2;
+    for (auto it = b.cbegin(); it != b.cend(); ++it, ++i)
+      assert(*it == i);
+  }
+
+  // Wyszukiwanie po string_view i const char* nie może alokować napisów.
+  // Usuwanie nie alokuje pamięci, o ile nie robi tego sam magazyn (erases).
+  template <typename B>
+  void transparent_test(bool erases) {
+    vector<string> keys;
+    for (size_t i = 0; i < 10; i++)
+      keys.push_back(string(100, 'k') + std::to_string(i));
+
+    B b;
+    b.insert_front(keys[0], 0);
+    for (size_t i = 1; i < 10; i++)
+      b.insert_after(string_view(keys[i - 1]), keys[i], static_cast<int>(i));
+
+    allocation_count = 0;
+    for (size_t i = 0; i < 10; i++) {
+      assert(as_const(b).read(string_view(keys[i])) == static_cast<int>(i));
+      assert(b.read(keys[i].c_str()) == static_cast<int>(i));
+    }
+    assert(allocation_count == 0);
+
+    b.remove(string_view(keys[9]));
+    assert(erases || allocation_count == 0);
+    assert(b.size() == 9);
+
+    bool catched = false;
+    try {
+      b.read(string_view(keys[9]));
+    }
+    catch (invalid_argument const &) {
+      catched = true;
+    }
+    assert(catched);
+
+    b.emplace_after(string_view(keys[8]), std::piecewise_construct, std::forward_as_tuple(keys[9]),
+                    std::forward_as_tuple(9));
+    vector<pair<string, int>> batch = {{"x", 10}, {"y", 11}};
+    b.insert_range_after(keys[9].c_str(), batch.begin(), batch.end());
+    assert(b.size() == 12);
+
+    int i = 0;
+    for (auto it = b.cbegin(); it != b.cend(); ++it, ++i)
+      assert(*it == i);
+
+    auto snapshot = b.snapshot();
+    assert(snapshot.read(string_view(keys[5])) == 5);
+    assert(snapshot.read("y") == 11);
+  }
+#endif
+
+#if TEST_NUM == 717 || TEST_NUM == 722
+  template <typename B>
+  concept positional = requires (B const b) { b.nth(0); };
+
+  // Wykonujemy losowy ciąg operacji na pozycjach jednocześnie na skoroszycie
+  // i na modelu, sprawdzając nth, index_of i cnth.
+  template <typename B>
+  void positional_test(unsigned seed, int steps, int max_size) {
+    using model_t = vector<pair<int, int>>;
+
+    B b;
+    model_t model;
+    vector<pair<B, model_t>> copies;
+    int next_key = 0;
+
+    auto random = [&seed](size_t n) {
+      seed = seed * 1103515245u + 12345u;
+      return static_cast<size_t>((seed >> 8) % n);
+    };
+
+    for (int step = 0; step < steps; step++) {
+      size_t op = random(8);
+      if (model.size() >= static_cast<size_t>(max_size) && op < 4)
+        op = 4;
+
+      if (op < 4 || model.empty()) {
+        size_t i = random(model.size() + 1);
+        b.insert_at(i, next_key, step);
+        model.insert(model.begin() + i, {next_key++, step});
+      }
+      else if (op == 4) {
+        size_t i = random(model.size());
+        b.remove(model[i].first);
+        model.erase(model.begin() + i);
+      }
+      else if (op == 5) {
+        size_t i = random(model.size());
+        b.nth(i) += 1000;
+        model[i].second += 1000;
+      }
+      else if (op == 6) {
+        copies.push_back({b, model});
+      }
+      else {
+        b.remove();
+        model.erase(model.begin());
+      }
+
+      assert(b.size() == model.size());
+      if (!model.empty()) {
+        size_t i = random(model.size());
+        assert(as_const(b).nth(i) == model[i].second);
+        assert(b.index_of(model[i].first) == i);
+      }
+
+      if (step % 100 == 0) {
+        for (size_t i = 0; i < model.size(); i++) {
+          assert(as_const(b).nth(i) == model[i].second);
+          assert(b.index_of(model[i].first) == i);
+        }
+        size_t from = random(model.size() + 1);
+        auto it = b.cnth(from);
+        for (size_t i = from; i < model.size(); i++, ++it)
+          assert(*it == model[i].second);
+        assert(it == b.cend());
+      }
+    }
+
+    for (auto const &[copy, copy_model] : copies) {
+      assert(copy.size() == copy_model.size());
+      for (size_t i = 0; i < copy_model.size(); i++)
+        assert(copy.nth(i) == copy_model[i].second);
+    }
+  }
+#endif
+
+#if TEST_NUM == 718
+  // Przechodzimy skoroszyt o kluczach 0, ..., n - 1 (w tej kolejności)
+  // w obu kierunkach, także iteratorami odwrotnymi.
+  template <typename B>
+  void bidirectional_test(size_t n) {
+    static_assert(std::bidirectional_iterator<typename B::const_iterator>);
+    static_assert(std::bidirectional_iterator<typename B::const_reverse_iterator>);
+    static_assert(std::ranges::bidirectional_range<B>);
+    static_assert(std::is_same_v<typename std::iterator_traits<typename B::const_iterator>::iterator_category,
+                                 std::bidirectional_iterator_tag>);
+
+    B b;
+    assert(b.crbegin() == b.crend());
+    for (size_t i = n; i-- > 0;)
+      b.insert_front(static_cast<int>(i), static_cast<int>(i * i));
+
+    size_t i = n;
+    for (auto it = b.cend(); it != b.cbegin();) {
+      --it;
+      --i;
+      assert(it.key() == static_cast<int>(i));
+      assert(*it == static_cast<int>(i * i));
+    }
+    assert(i == 0);
+
+    i = n;
+    for (auto it = b.crbegin(); it != b.crend(); ++it) {
+      --i;
+      assert(it.key() == static_cast<int>(i));
+    }
+    assert(i == 0);
+
+    auto rit = b.crend();
+    --rit;
+    assert(rit.key() == 0);
+    assert(std::prev(b.cend()).key() == static_cast<int>(n - 1));
+
+    auto reversed = b | std::views::reverse;
+    assert(*reversed.begin() == static_cast<int>((n - 1) * (n - 1)));
+    auto found = std::ranges::find(b, 25);
+    assert(found != b.cend() && found.key() == 5);
+
+    auto snapshot = b.snapshot();
+    i = 0;
+    for (int v : snapshot) {
+      assert(v == static_cast<int>(i * i));
+      ++i;
+    }
+    assert(i == n);
+    assert(snapshot.crbegin().key() == static_cast<int>(n - 1));
+  }
+#endif
+
+#if TEST_NUM == 719
+  // Przestawiamy losowo notatki skoroszytu jednocześnie w modelu. Jeśli
+  // relinks_only, przestawianie niewspółdzielonego skoroszytu nie alokuje.
+  template <typename B>
+  void move_test(unsigned seed, int steps, bool relinks_only) {
+    using model_t = vector<pair<int, int>>;
+
+    B b;
+    model_t model;
+    for (int i = 0; i < 100; i++) {
+      b.insert_front(i, i);
+      model.insert(model.begin(), {i, i});
+    }
+    vector<pair<B, model_t>> copies;
+
+    auto random = [&seed](size_t n) {
+      seed = seed * 1103515245u + 12345u;
+      return static_cast<size_t>((seed >> 8) % n);
+    };
+    auto position_of = [&model](int k) {
+      return std::find_if(model.begin(), model.end(), [k](auto const &p) {return p.first == k;});
+    };
+    auto relink = [&](int k, auto const &where) {
+      auto it = position_of(k);
+      auto note = *it;
+      model.erase(it);
+      model.insert(where(), note);
+    };
+
+    allocation_count = 0;
+    for (int step = 0; step < steps; step++) {
+      size_t op = random(10);
+      int k = model[random(model.size())].first;
+
+      if (op < 3) {
+        b.move_front(k);
+        relink(k, [&] {return model.begin();});
+      }
+      else if (op < 6) {
+        b.move_back(k);
+        relink(k, [&] {return model.end();});
+      }
+      else if (op < 9) {
+        int prev_k = model[random(model.size())].first;
+        b.move_after(prev_k, k);
+        if (prev_k != k)
+          relink(k, [&] {return position_of(prev_k) + 1;});
+      }
+      else {
+        copies.push_back({b, model});
+        // Pierwsze przestawienie po skopiowaniu kopiuje notatki.
+        allocation_count = 0;
+        b.move_front(k);
+        relink(k, [&] {return model.begin();});
+        allocation_count = 0;
+      }
+    }
+    assert(!relinks_only || allocation_count == 0);
+    assert(matches_model(b, model));
+
+    for (auto const &[copy, copy_model] : copies)
+      assert(matches_model(copy, copy_model));
+
+    bool catched = false;
+    try {
+      b.move_after(1000, 0);
+    }
+    catch (invalid_argument const &) {
+      catched = true;
+    }
+    assert(catched);
+    assert(matches_model(b, model));
+  }
+#endif
+
+#if TEST_NUM == 720
+  // Adresy notatek skoroszytu w kolejności notatek.
+  template <typename B>
+  vector<int const *> addresses(B const &b) {
+    vector<int const *> result;
+    for (auto it = b.cbegin(); it != b.cend(); ++it)
+      result.push_back(&*it);
+    return result;
+  }
+
+  // Losowo dzielimy skoroszyty i łączymy je z powrotem, jednocześnie na
+  // modelach. Jeśli relinks_only, łączenie i dzielenie niewspółdzielonych
+  // skoroszytów przenosi notatki bez kopiowania.
+  template <typename B>
+  void splice_test(unsigned seed, int steps, bool relinks_only) {
+    using model_t = vector<pair<int, int>>;
+
+    vector<pair<B, model_t>> pieces(1);
+    for (int i = 0; i < 200; i++) {
+      pieces[0].first.insert_front(i, i);
+      pieces[0].second.insert(pieces[0].second.begin(), {i, i});
+    }
+    vector<pair<B, model_t>> copies;
+
+    auto random = [&seed](size_t n) {
+      seed = seed * 1103515245u + 12345u;
+      return static_cast<size_t>((seed >> 8) % n);
+    };
+    auto position_of = [](model_t const &model, int k) {
+      return std::find_if(model.begin(), model.end(), [k](auto const &p) {return p.first == k;});
+    };
+
+    for (int step = 0; step < steps; step++) {
+      size_t op = random(10);
+      size_t i = random(pieces.size());
+      auto &[b, model] = pieces[i];
+
+      if (op < 4 && !model.empty()) {
+        int k = model[random(model.size())].first;
+        B tail = b.split_after(k);
+        auto split = position_of(model, k) + 1;
+        model_t tail_model(split, model.cend());
+        model.erase(split, model.cend());
+        pieces.push_back({std::move(tail), std::move(tail_model)});
+      }
+      else if (op < 8 && pieces.size() > 1) {
+        size_t j = random(pieces.size() - 1);
+        j += j >= i;
+        auto &[other, other_model] = pieces[j];
+        size_t where = model.empty() ? random(2) : random(3);
+        if (where == 0) {
+          b.splice_front(std::move(other));
+          model.insert(model.begin(), other_model.begin(), other_model.end());
+        }
+        else if (where == 1) {
+          b.splice_back(std::move(other));
+          model.insert(model.end(), other_model.begin(), other_model.end());
+        }
+        else {
+          int prev_k = model[random(model.size())].first;
+          b.splice_after(prev_k, std::move(other));
+          model.insert(position_of(model, prev_k) + 1, other_model.begin(), other_model.end());
+        }
+        assert(other.size() == 0);
+        pieces.erase(pieces.begin() + static_cast<std::ptrdiff_t>(j));
+      }
+      else if (op == 8) {
+        copies.push_back(pieces[i]);
+      }
+      else if (!model.empty()) {
+        // Wspólna zakładka jest wykrywana, zanim cokolwiek się zmieni.
+        B other;
+        other.insert_front(1000, 0);
+        other.insert_front(model[random(model.size())].first, 0);
+        bool catched = false;
+        try {
+          b.splice_back(std::move(other));
+        }
+        catch (invalid_argument const &) {
+          catched = true;
+        }
+        assert(catched);
+        assert(other.size() == 2);
+      }
+
+      for (auto const &[piece, piece_model] : pieces)
+        assert(matches_model(piece, piece_model));
+    }
+
+    for (auto const &[copy, copy_model] : copies)
+      assert(matches_model(copy, copy_model));
+
+    B a, c;
+    for (int i = 0; i < 100; i++)
+      a.insert_front(i, i);
+    for (int i = 100; i < 110; i++)
+      c.insert_front(i, i);
+    vector<int const *> before = addresses(a);
+    vector<int const *> spliced = addresses(c);
+    before.insert(before.begin() + 50, spliced.begin(), spliced.end());
+
+    a.splice_after(50, std::move(c));
+    assert(a.size() == 110 && c.size() == 0);
+    assert(!relinks_only || addresses(a) == before);
+
+    B t = a.split_after(97);
+    B u = t.split_after(2);
+    assert(a.size() == 3 && t.size() == 105 && u.size() == 2);
+    c.splice_back(std::move(u));
+    c.splice_front(std::move(a));
+    c.splice_after(97, std::move(t));
+    assert(c.size() == 110);
+    assert(!relinks_only || addresses(c) == before);
+
+    bool catched = false;
+    try {
+      [[maybe_unused]] B w = c.split_after(1000);
+    }
+    catch (invalid_argument const &) {
+      catched = true;
+    }
+    assert(catched);
+    catched = false;
+    try {
+      c.splice_after(1000, std::move(a));
+    }
+    catch (invalid_argument const &) {
+      catched = true;
+    }
+    assert(catched);
+    assert(c.size() == 110);
+  }
+#endif
+
+#if TEST_NUM == 721
+  // Puste skoroszyty, także kopiowane i przenoszone, nie alokują pamięci.
+  // Dane powstają dopiero przy pierwszym wstawieniu.
+  template <typename B>
+  void empty_binder_test() {
+    static_assert(std::is_nothrow_default_constructible_v<B>);
+
+    allocation_count = 0;
+    {
+      B many[1000];
+      B b;
+      B c(b);
+      B d(std::move(c));
+      d = b;
+      auto snapshot = b.snapshot();
+      assert(b.size() == 0 && b.cbegin() == b.cend() && b.crbegin() == b.crend());
+      assert(!b.contains(1) && b.find(1) == nullptr && snapshot.size() == 0);
+      assert(b.try_remove() == cxx::binder_status::empty);
+      assert(b.try_remove(1) == cxx::binder_status::key_not_found);
+      b.clear();
+      vector<pair<int, int>> none;
+      b.insert_range_front(none.begin(), none.end());
+      b.splice_front(std::move(c));
+      b.splice_back(std::move(d));
+      assert(b.try_insert_after(1, 2, 3) == cxx::binder_status::key_not_found);
+      assert(b.size() == 0 && many[999].size() == 0);
+    }
+    assert(allocation_count == 0);
+
+    // Nieudane wstawienie za brakującym kluczem alokuje tylko treść wyjątku.
+    size_t thrown = 0;
+    try {
+      throw invalid_argument("Key already exists");
+    }
+    catch (invalid_argument const &) {
+      thrown = allocation_count;
+    }
+    allocation_count = 0;
+    {
+      B b;
+      bool catched = false;
+      try {
+        b.insert_after(1, 2, 3);
+      }
+      catch (invalid_argument const &) {
+        catched = true;
+      }
+      assert(catched && allocation_count == thrown);
+      catched = false;
+      try {
+        b.emplace_after(1, std::piecewise_construct, std::forward_as_tuple(2), std::forward_as_tuple(3));
+      }
+      catch (invalid_argument const &) {
+        catched = true;
+      }
+      assert(catched && allocation_count == 2 * thrown);
+      assert(b.size() == 0);
+    }
+    allocation_count = 0;
+
+    B b;
+    b.insert_front(1, 1);
+    assert(allocation_count > 0);
+    B moved(std::move(b));
+    assert(b.size() == 0);
+    b.insert_front(2, 2);
+    assert(b.read(2) == 2 && moved.read(1) == 1);
+  }
+#endif
+
+#if TEST_NUM == 723
+  // Czy kolejne notatki skoroszytu leżą w pamięci jedna za drugą.
+  template <typename B>
+  bool sequential(B const &b) {
+    auto it = b.cbegin();
+    if (it == b.cend())
+      return true;
+    std::ptrdiff_t step = 0;
+    for (auto next = std::next(it); next != b.cend(); it = next++) {
+      auto bytes = reinterpret_cast<char const *>(&*next) - reinterpret_cast<char const *>(&*it);
+      if (bytes <= 0 || (step != 0 && bytes != step))
+        return false;
+      step = bytes;
+    }
+    return true;
+  }
+
+  // Notatki dopisywane na koniec leżą w kolejności. Po przestawieniu
+  // kolejność w pamięci wraca najpóźniej przy przebudowie wektora.
+  template <typename B>
+  void layout_test() {
+    B b;
+    b.insert_front(0, 0);
+    for (int i = 1; i < 100; i++)
+      b.insert_after(i - 1, i, i);
+    assert(sequential(b));
+
+    b.move_front(50);
+    b.remove(20);
+    assert(!sequential(b));
+
+    // Kopia danych przy pierwszym zapisie układa notatki w kolejności.
+    B copy(b);
+    copy.insert_after(99, -1, -1);
+    assert(sequential(copy));
+
+    int appended = 0;
+    for (int k = 100; !sequential(b); k++, appended++)
+      b.insert_after(k == 100 ? 99 : k - 1, k, k);
+    assert(appended <= 200);
+    assert(b.size() == 99 + static_cast<size_t>(appended));
+    assert(*b.cbegin() == 50);
+  }
+#endif
+
+#if TEST_NUM == 707
+  // Zasób pamięci zliczający bloki pobrane przez skoroszyty.
+  class counting_resource : public std::pmr::memory_resource {
+  public:
+    size_t blocks = 0;
+    size_t in_use = 0;
+
+  private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+      void* p = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+      ++blocks;
+      in_use += bytes;
+      return p;
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+      in_use -= bytes;
+      std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(std::pmr::memory_resource const &other) const noexcept override {
+      return this == &other;
+    }
+  };
+
+  counting_resource counting;
+
+  std::pmr::memory_resource* counting_upstream() {
+    return &counting;
+  }
+#endif
 } // koniec anonimowej przestrzeni nazw
 
+#if TEST_NUM == 715
+template <>
+struct std::less<Version> {
+  bool operator()(Version const &a, Version const &b) const {
+    ++Version::comparisons;
+    return a.number > b.number;
+  }
+};
+#endif
+
 // Operatory new nie mogą być deklarowane w anonimowej przestrzeni nazw.
-#if TEST_NUM > 400 && TEST_NUM <= 599
+#if (TEST_NUM > 400 && TEST_NUM <= 599) || TEST_NUM == 703 || TEST_NUM == 705 || TEST_NUM == 706 || \
+    TEST_NUM == 708 || TEST_NUM == 715 || TEST_NUM == 717 || TEST_NUM == 719 || TEST_NUM == 721 || \
+    TEST_NUM == 722 || TEST_NUM == 723 || TEST_NUM == 724 || TEST_NUM == 725 || TEST_NUM == 726 || \
+    TEST_NUM == 727 || TEST_NUM == 729
 void* operator new(size_t size) {
   try {
+#if TEST_NUM == 706 || TEST_NUM == 715 || TEST_NUM == 719 || TEST_NUM == 721 || TEST_NUM == 722 || \
+    TEST_NUM == 726 || TEST_NUM == 727 || TEST_NUM == 729
+    ++allocation_count;
+#endif
     ThisCanThrow();
     void* p = malloc(size);
     if (!p)
@@ -378,7 +1387,8 @@ void* operator new(size_t size) {
 void* operator new(size_t size, align_val_t al) {
   try {
     ThisCanThrow();
-    void* p = aligned_alloc(static_cast<size_t>(al), size);
+    size_t alignment = static_cast<size_t>(al);
+    void* p = aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
     if (!p)
       throw "aligned_alloc";
     return p;
@@ -404,7 +1414,8 @@ void* operator new[](size_t size) {
 void* operator new[](size_t size, align_val_t al) {
   try {
     ThisCanThrow();
-    void* p = aligned_alloc(static_cast<size_t>(al), size);
+    size_t alignment = static_cast<size_t>(al);
+    void* p = aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
     if (!p)
       throw "aligned_alloc";
     return p;
@@ -2134,4 +3145,1262 @@ int main() {
 
   assert(Key::instance_count == 0);
 #endif
+
+// Testujemy trwałą pamięć (persistent_storage): kopie współdzielą węzły,
+// a modyfikacja kopii nie kopiuje wszystkich notatek.
+#if TEST_NUM == 701
+  using persistent_binder = binder<Key, Value, cxx::persistent_storage>;
+
+  do {
+    persistent_binder b1;
+
+    for (size_t i = 0; i < 1000; i++)
+      b1.insert_front(Key(i), Value(i));
+
+    assert(b1.size() == 1000);
+    assert(Key::instance_count == 1000);
+    assert(Value::instance_count == 1000);
+
+    Key::operation_count = 0;
+    Value::operation_count = 0;
+
+    persistent_binder b2(b1);
+
+    assert(Key::operation_count == 0 && Value::operation_count == 0);
+
+    b2.insert_after(Key(500), Key(5000), Value(5000));
+
+    clog << "Liczba przechowywanych zakładek: " << Key::instance_count << '\n';
+    clog << "Liczba przechowywanych notatek: " << Value::instance_count << '\n';
+
+    assert(Key::instance_count == 1001);
+    assert(Value::instance_count == 1001);
+    assert(b1.size() == 1000);
+    assert(b2.size() == 1001);
+    assert_not_in(b1, Key(5000));
+    assert(as_const(b2).read(Key(5000)).value == 5000);
+
+    b2.read(Key(7)).value = 77;
+
+    assert(Value::instance_count == 1002);
+    assert(as_const(b1).read(Key(7)).value == 7);
+    assert(as_const(b2).read(Key(7)).value == 77);
+
+    b2.read(Key(7)).value = 78;
+
+    assert(Value::instance_count == 1002);
+
+    b2.remove(Key(8));
+    b2.remove();
+
+    assert(Key::instance_count == 1001);
+    assert(Value::instance_count == 1002);
+    assert_not_in(b2, Key(8));
+    assert_not_in(b2, Key(999));
+    assert(as_const(b1).read(Key(8)).value == 8);
+    assert(b1.cbegin()->value == 999);
+    assert(b2.cbegin()->value == 998);
+
+    vector<size_t> expected;
+    for (size_t i = 998; i != static_cast<size_t>(-1); i--) {
+      if (i != 8)
+        expected.push_back(i == 7 ? 78 : i);
+      if (i == 500)
+        expected.push_back(5000);
+    }
+
+    size_t n = 0;
+    for (auto it = b2.cbegin(); it != b2.cend(); ++it)
+      assert(it->value == expected[n++]);
+    assert(n == expected.size());
+
+    persistent_binder b3(b2);
+    b3.clear();
+    assert(b3.size() == 0);
+    assert(b2.size() == 999);
+  } while (0);
+
+  // Kopia skoroszytu przeniesionego po wydaniu referencji jest pusta.
+  do {
+    binder<int, int> a;
+    a.insert_front(1, 1);
+    a.read(1) = 5;
+    binder<int, int> b(std::move(a));
+    binder<int, int> c(a);
+    assert(c.size() == 0 && b.read(1) == 5);
+    auto s = a.snapshot();
+    assert(s.size() == 0);
+    c = a;
+    assert(c.size() == 0);
+
+    persistent_binder p;
+    p.insert_front(Key(1), Value(1));
+    p.read(Key(1)).value = 5;
+    persistent_binder q;
+    q = std::move(p);
+    persistent_binder r(p);
+    assert(r.size() == 0 && as_const(q).read(Key(1)).value == 5);
+  } while (0);
+
+  assert(Key::instance_count == 0);
+  assert(Value::instance_count == 0);
+#endif
+
+// Porównujemy działanie skoroszytów z modelem dla losowego ciągu operacji.
+#if TEST_NUM == 702
+  random_operations_test<binder<int, int>>(1, 4000, 300);
+  random_operations_test<binder<int, int, cxx::persistent_storage>>(1, 4000, 300);
+  random_operations_test<binder<int, int, cxx::persistent_storage>>(7, 20000, 40);
+  random_operations_test<binder<int, int, cxx::ranked_storage>>(3, 4000, 300);
+#endif
+
+// Testujemy silne gwarancje dla trwałej pamięci.
+#if TEST_NUM == 703
+  vector<Value> values;
+  for (size_t i = 0; i <= 20; i++) {
+    Value v(i);
+    values.push_back(v);
+  }
+
+  strong_operations_test<binder<Key, Value, cxx::persistent_storage>>(values);
+#endif
+
+// Testujemy indeks haszujący (hash_index).
+#if TEST_NUM == 704
+  struct bad_hash {
+    size_t operator()(int k) const noexcept {
+      return static_cast<size_t>(k % 3);
+    }
+  };
+
+  random_operations_test<binder<int, int, cxx::hash_index<>>>(3, 4000, 300);
+  random_operations_test<binder<int, int, cxx::hash_index<>>>(5, 20000, 40);
+  random_operations_test<binder<int, int, cxx::hash_index<bad_hash>>>(11, 3000, 100);
+
+  binder<Key, Value, cxx::hash_index<KeyHash>> bi;
+
+  for (size_t i = 0; i < 1000; i++) {
+    bi.insert_front(Key(10 * i), Value(i));
+    for (size_t j = 1; j < 10; j++)
+      bi.insert_after(Key(10 * i), Key(10 * i + j), Value(i));
+  }
+
+  assert(bi.size() == 10000);
+  assert(Key::instance_count == 10000);
+  assert(Value::instance_count == 10000);
+
+  Key::operation_count = 0;
+  bi.insert_after(Key(777), Key(777777), Value(0));
+
+  clog << "Liczba operacji wykonanych przez insert_after: " << Key::operation_count << "\n";
+
+  assert(Key::operation_count <= 30);
+
+  bi.remove(Key(777));
+  bi.remove();
+  assert_not_in(bi, Key(777));
+  assert_not_in(bi, Key(9990));
+  assert(as_const(bi).read(Key(777777)).value == 0);
+  assert(bi.size() == 9999);
+
+  binder<Key, Value, cxx::hash_index<KeyHash>> bu(bi);
+  bu.read(Key(5)).value = 55;
+  assert(as_const(bi).read(Key(5)).value == 0);
+  assert(as_const(bu).read(Key(5)).value == 55);
+  assert(Value::instance_count == 2 * 9999);
+#endif
+
+// Testujemy silne gwarancje dla indeksu haszującego.
+#if TEST_NUM == 705
+  vector<Value> values;
+  for (size_t i = 0; i <= 20; i++) {
+    Value v(i);
+    values.push_back(v);
+  }
+
+  strong_operations_test<binder<Key, Value, cxx::hash_index<KeyHash>>>(values);
+#endif
+
+// Testujemy liczbę alokacji: każda notatka to jedna alokacja.
+#if TEST_NUM == 706
+  binder<int, int, cxx::ordered_index<>> bi;
+  bi.insert_front(0, 0);
+
+  size_t allocations = allocation_count;
+  for (int i = 1; i <= 1000; i++)
+    bi.insert_after(i - 1, i, i);
+
+  clog << "Liczba alokacji dla 1000 notatek: " << allocation_count - allocations << "\n";
+  assert(allocation_count - allocations == 1000);
+
+  allocations = allocation_count;
+  binder<int, int, cxx::ordered_index<>> bu(bi);
+  bu.insert_front(-1, -1);
+
+  // Kopia danych (jedna alokacja), 1001 skopiowanych notatek, tymczasowa mapa
+  // węzłów kopiowanego drzewa i nowa notatka.
+  assert(allocation_count - allocations == 1004);
+
+  allocations = allocation_count;
+  bu.remove(500);
+  bu.remove();
+  assert(allocation_count == allocations);
+
+  binder<int, int, cxx::hash_index<>> bh;
+  bh.insert_front(0, 0);
+
+  allocations = allocation_count;
+  for (int i = 1; i <= 1000; i++)
+    bh.insert_after(i - 1, i, i);
+
+  clog << "Liczba alokacji dla 1000 notatek (hash_index): " << allocation_count - allocations << "\n";
+  assert(allocation_count - allocations <= 1000 + 10);
+
+  int i = 0;
+  for (auto it = bh.cbegin(); it != bh.cend(); ++it)
+    assert(*it == i++);
+  assert(i == 1001);
+#endif
+
+// Testujemy pulę pamięci skoroszytu (pool_allocator) i własny zasób pamięci.
+#if TEST_NUM == 707
+  using pool_binder = binder<int, int, cxx::pool_allocator<counting_upstream>>;
+
+  random_operations_test<pool_binder>(1, 4000, 300);
+  random_operations_test<binder<int, int, cxx::hash_index<>, cxx::pool_allocator<counting_upstream>>>(3, 4000, 300);
+  assert(counting.in_use == 0);
+
+  do {
+    size_t blocks = counting.blocks;
+    pool_binder b;
+    b.insert_front(0, 0);
+    for (int i = 1; i < 10000; i++)
+      b.insert_after(i - 1, i, i);
+
+    clog << "Liczba bloków pobranych dla 10000 notatek: " << counting.blocks - blocks << "\n";
+    assert(counting.blocks - blocks < 100);
+
+    // Węzły usuniętych notatek są używane ponownie.
+    size_t in_use = counting.in_use;
+    for (int i = 0; i < 5000; i++)
+      b.remove();
+    for (int i = 0; i < 5000; i++)
+      b.insert_front(-1 - i, i);
+    assert(counting.in_use == in_use);
+
+    pool_binder c(b);
+    c.insert_front(20000, 0);
+    assert(c.size() == 10001);
+    assert(b.size() == 10000);
+
+    // Wyczyszczenie oddaje całą pamięć puli naraz.
+    in_use = counting.in_use;
+    b.clear();
+    assert(counting.in_use < in_use);
+    assert(b.size() == 0);
+    b.insert_front(1, 1);
+    assert(b.read(1) == 1);
+    assert(c.read(5000) == 5000);
+  } while (0);
+  assert(counting.in_use == 0);
+
+  do {
+    binder<string, string, cxx::pool_allocator<counting_upstream>> bs;
+    for (int i = 0; i < 100; i++)
+      bs.insert_front(std::to_string(i), string(100, static_cast<char>('a' + i % 26)));
+
+    auto bs2 = bs;
+    bs2.remove("50");
+    bs.clear();
+    assert(bs2.size() == 99);
+    assert(bs2.read("51") == string(100, 'z'));
+  } while (0);
+  assert(counting.in_use == 0);
+
+  binder<int, int, cxx::ordered_index<>, cxx::resource_allocator<counting_upstream>> br;
+  size_t blocks = counting.blocks;
+  for (int i = 0; i < 1000; i++)
+    br.insert_front(i, i);
+  assert(counting.blocks - blocks == 1000);
+  br.clear();
+  assert(counting.in_use == 0);
+
+  binder<int, int, cxx::pool_allocator<>> bd;
+  bd.insert_front(1, 1);
+  bd.insert_after(1, 2, 2);
+  assert(bd.read(2) == 2);
+#endif
+
+// Testujemy silne gwarancje dla puli pamięci skoroszytu.
+#if TEST_NUM == 708
+  vector<Value> values;
+  for (size_t i = 0; i <= 20; i++) {
+    Value v(i);
+    values.push_back(v);
+  }
+
+  strong_operations_test<binder<Key, Value, cxx::pool_allocator<>>>(values);
+  strong_operations_test<binder<Key, Value, cxx::hash_index<KeyHash>, cxx::pool_allocator<>>>(values);
+#endif
+
+// Testujemy skoroszyty z nieatomowym licznikiem referencji (single_threaded).
+#if TEST_NUM == 709
+  random_operations_test<binder<int, int, cxx::single_threaded>>(1, 4000, 300);
+  random_operations_test<binder<int, int, cxx::persistent_storage, cxx::single_threaded>>(7, 4000, 40);
+
+  binder<Key, Value, cxx::single_threaded> bs;
+  for (size_t i = 0; i < 100; i++)
+    bs.insert_front(Key(i), Value(i));
+
+  vector<binder<Key, Value, cxx::single_threaded>> vec;
+  for (size_t i = 0; i < 1000; i++)
+    vec.push_back(bs);
+  assert(Key::instance_count == 100);
+  assert(Value::instance_count == 100);
+
+  vec[10].remove(Key(10));
+  assert(Key::instance_count == 199);
+  assert(vec[10].size() == 99);
+  assert(bs.size() == 100);
+
+  vec.clear();
+  bs.clear();
+  assert(Key::instance_count == 0);
+  assert(Value::instance_count == 0);
+#endif
+
+// Testujemy kopiowanie przy zapisie dla skoroszytów przekazywanych między wątkami.
+#if TEST_NUM == 710
+  concurrent_test<binder<int, int>>(8, 2000);
+  concurrent_test<binder<int, int, cxx::hash_index<>, cxx::pool_allocator<>>>(8, 2000);
+  concurrent_test<binder<int, int, cxx::persistent_storage>>(8, 1000);
+#endif
+
+// Testujemy migawki skoroszytu.
+#if TEST_NUM == 711
+  binder<Key, Value> bi;
+  for (size_t i = 0; i < 10; i++)
+    bi.insert_front(Key(i), Value(i));
+
+  Key::operation_count = 0;
+  auto s1 = bi.snapshot();
+  assert(Key::operation_count == 0);
+  assert(Key::instance_count == 10);
+  assert(Value::instance_count == 10);
+
+  bi.remove(Key(3));
+  bi.insert_front(Key(100), Value(100));
+  assert(s1.size() == 10);
+  assert(s1.read(Key(3)).value == 3);
+  assert(bi.size() == 10);
+
+  size_t i = 9;
+  for (auto it = s1.cbegin(); it != s1.cend(); ++it, --i)
+    assert(it->value == i);
+
+  // Migawka nie może się zmienić przez referencję zwróconą wcześniej przez read.
+  Value &v = bi.read(Key(5));
+  auto s2 = bi.snapshot();
+  v.value = 55;
+  assert(s2.read(Key(5)).value == 5);
+  assert(as_const(bi).read(Key(5)).value == 55);
+
+  decltype(s1) s3;
+  assert(s3.size() == 0);
+  assert(s3.cbegin() == s3.cend());
+  s3 = s1;
+  s1 = s2;
+  assert(s3.read(Key(3)).value == 3);
+  assert(s1.read(Key(5)).value == 5);
+
+  snapshot_readers_test<binder<int, int>>(4, 3000);
+  snapshot_readers_test<binder<int, int, cxx::persistent_storage>>(4, 3000);
+#endif
+
+// Testujemy wstawianie wielu notatek naraz.
+#if TEST_NUM == 712
+  binder<Key, Value> bi;
+  bi.insert_front(Key(0), Value(0));
+  bi.insert_after(Key(0), Key(1), Value(1));
+
+  vector<pair<Key, Value>> batch;
+  for (size_t i = 10; i < 15; i++)
+    batch.emplace_back(Key(i), Value(i));
+
+  binder<Key, Value> copy(bi);
+  Key::operation_count = 0;
+  bi.insert_range_after(Key(0), batch.begin(), batch.end());
+  clog << "Liczba operacji wykonanych przez insert_range_after: " << Key::operation_count << "\n";
+
+  assert(copy.size() == 2);
+  assert(bi.size() == 7);
+  size_t expected[] = {0, 10, 11, 12, 13, 14, 1};
+  size_t n = 0;
+  for (auto it = bi.cbegin(); it != bi.cend(); ++it)
+    assert(it->value == expected[n++]);
+
+  // Powtórzona zakładka w partii: żadna notatka nie zostaje wstawiona.
+  vector<pair<Key, Value>> bad_batch;
+  bad_batch.emplace_back(Key(20), Value(20));
+  bad_batch.emplace_back(Key(21), Value(21));
+  bad_batch.emplace_back(Key(20), Value(22));
+
+  for (auto *b : {&bi, &copy}) {
+    size_t size = b->size();
+    size_t instances = Key::instance_count;
+    bool catched = false;
+    try {
+      b->insert_range_front(bad_batch.begin(), bad_batch.end());
+    }
+    catch (invalid_argument const &) {
+      catched = true;
+    }
+    assert(catched);
+    assert(b->size() == size);
+    assert(Key::instance_count == instances);
+    assert_not_in(*b, Key(21));
+  }
+
+  bool catched = false;
+  try {
+    bi.insert_range_front(batch.begin(), batch.begin() + 1);
+  }
+  catch (invalid_argument const &) {
+    catched = true;
+  }
+  assert(catched);
+
+  catched = false;
+  try {
+    bi.insert_range_after(Key(100), bad_batch.begin(), bad_batch.begin() + 1);
+  }
+  catch (invalid_argument const &) {
+    catched = true;
+  }
+  assert(catched);
+  assert(bi.size() == 7);
+
+  bi.insert_range_front(batch.end(), batch.end());
+  assert(bi.size() == 7);
+
+  // Zakres zakończony wartownikiem.
+  binder<int, int> bs;
+  vector<pair<int, int>> ints;
+  for (int i = 0; i < 100; i++)
+    ints.emplace_back(i, -i);
+  bs.insert_range_front(std::counted_iterator(ints.begin(), 50), std::default_sentinel);
+  bs.insert_range_after(49, ints.begin() + 50, ints.end());
+  int i = 0;
+  for (auto it = bs.cbegin(); it != bs.cend(); ++it, ++i)
+    assert(*it == -i);
+  assert(i == 100);
+
+  binder<int, int, cxx::persistent_storage> bp;
+  bp.insert_range_front(ints.begin(), ints.end());
+  binder<int, int, cxx::persistent_storage> bp_copy(bp);
+  vector<pair<int, int>> bad_ints = {{200, 0}, {201, 0}, {5, 0}};
+  catched = false;
+  try {
+    bp.insert_range_after(10, bad_ints.begin(), bad_ints.end());
+  }
+  catch (invalid_argument const &) {
+    catched = true;
+  }
+  assert(catched);
+  assert(bp == bp_copy);
+  assert(bp.size() == 100);
+#endif
+
+// Testujemy konstruktor z zakresu par (zakładka, notatka).
+#if TEST_NUM == 713
+  vector<pair<Key, Value>> sorted, shuffled;
+  for (size_t i = 0; i < 1000; i++) {
+    sorted.emplace_back(Key(i), Value(i));
+    shuffled.emplace_back(Key(i * 7919 % 1000), Value(i * 7919 % 1000));
+  }
+
+  Key::operation_count = 0;
+  binder<Key, Value> bs(sorted.begin(), sorted.end());
+  clog << "Liczba operacji dla 1000 posortowanych zakładek: " << Key::operation_count << "\n";
+  assert(Key::operation_count <= 6 * 1000);
+
+  binder<Key, Value> bu(shuffled.begin(), shuffled.end());
+  assert(bs.size() == 1000);
+  assert(bu.size() == 1000);
+  size_t i = 0;
+  for (auto it = bs.cbegin(); it != bs.cend(); ++it, ++i)
+    assert(it->value == i);
+  i = 0;
+  for (auto it = bu.cbegin(); it != bu.cend(); ++it, ++i)
+    assert(it->value == i * 7919 % 1000);
+
+  size_t keys = Key::instance_count;
+  size_t values = Value::instance_count;
+
+  shuffled.emplace_back(Key(500), Value(0));
+  bool catched = false;
+  try {
+    binder<Key, Value> bd(shuffled.begin(), shuffled.end());
+  }
+  catch (invalid_argument const &) {
+    catched = true;
+  }
+  assert(catched);
+  assert(Key::instance_count == keys + 1);
+  assert(Value::instance_count == values + 1);
+
+  // Wyjątek w trakcie budowania nie może zostawić żadnych obiektów.
+  for (int trials = 1; ; trials++) {
+    bool success = true;
+    throw_countdown = trials;
+    throw_checking = true;
+    try {
+      binder<Key, Value, cxx::hash_index<KeyHash>> bh(sorted.begin(), sorted.end());
+      throw_checking = false;
+      assert(bh.size() == 1000);
+    }
+    catch (...) {
+      throw_checking = false;
+      success = false;
+    }
+    assert(Key::instance_count == keys + 1);
+    assert(Value::instance_count == values + 1);
+    if (success)
+      break;
+  }
+
+  auto squares = std::views::iota(0, 100) | std::views::transform([](int i) {return pair(i, i * i);});
+  binder<int, int, cxx::persistent_storage> bp(squares.begin(), squares.end());
+  int j = 0;
+  for (auto it = bp.cbegin(); it != bp.cend(); ++it, ++j)
+    assert(*it == j * j);
+  assert(j == 100);
+
+#ifdef __cpp_lib_containers_ranges
+  binder<int, int, cxx::hash_index<>> br(std::from_range, squares);
+  assert(br.size() == 100);
+  assert(br.read(9) == 81);
+#endif
+#endif
+
+// Testujemy przenoszenie i budowanie notatek w miejscu.
+#if TEST_NUM == 714
+  emplace_test<binder<string, Payload>>(10);
+  emplace_test<binder<string, Payload, cxx::hash_index<>>>(10);
+  emplace_test<binder<string, Payload, cxx::persistent_storage>>(0);
+
+  // Przenoszące iteratory przenoszą notatki całego zakresu.
+  vector<pair<string, Payload>> batch;
+  for (size_t i = 0; i < 10; i++)
+    batch.emplace_back(std::to_string(i), Payload(100, 'b'));
+  Payload::copies = 0;
+
+  binder<string, Payload> bm(std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+  assert(Payload::copies == 0);
+  assert(batch[3].second.data.empty());
+  assert(bm.size() == 10);
+
+  vector<pair<string, Payload>> more;
+  for (size_t i = 0; i < 10; i++)
+    more.emplace_back("m" + std::to_string(i), Payload(50, 'c'));
+  Payload::copies = 0;
+
+  bm.insert_range_after("9", std::make_move_iterator(more.begin()), std::make_move_iterator(more.end()));
+  assert(Payload::copies == 0);
+  assert(more[0].second.data.empty());
+  assert(bm.size() == 20);
+  assert(as_const(bm).read("m9").data.size() == 50);
+#endif
+
+// Testujemy wyszukiwanie notatek po kluczach innego typu niż K.
+#if TEST_NUM == 715
+  transparent_test<binder<string, int>>(false);
+  transparent_test<binder<string, int, cxx::hash_index<StringHash, std::equal_to<>>>>(false);
+  transparent_test<binder<string, int, cxx::persistent_storage>>(true);
+
+  binder<string, int> bc;
+  bc.insert_front("abc", 1);
+  assert(bc.contains(string_view("abc")));
+  assert(!bc.contains("abd"));
+  assert(bc.try_remove(string_view("abd")) == cxx::binder_status::key_not_found);
+  assert(bc.try_insert_after(string_view("abc"), "abd", 2) == cxx::binder_status::ok);
+  assert(*as_const(bc).find("abd") == 2);
+
+  // Domyślny indeks zakładek spoza biblioteki standardowej porządkuje je
+  // przez std::less<K>, także gdy ta jest specjalizowana.
+  static_assert(std::is_same_v<cxx::ordered_index<>::compare<Version>, std::less<Version>>);
+  static_assert(std::is_same_v<cxx::ordered_index<>::compare<string>, std::less<>>);
+  static_assert(std::is_same_v<cxx::ordered_index<>::compare<int>, std::less<int>>);
+
+  // Zakładki liczbowe szukane wartością innego typu są najpierw zamieniane
+  // na K, w obu indeksach tak samo.
+  {
+    binder<int, int, cxx::ordered_index<>> bo;
+    binder<int, int, cxx::hash_index<>> bh;
+    binder<unsigned, int, cxx::ordered_index<>> uo;
+    binder<unsigned, int, cxx::hash_index<>> uh;
+    bo.insert_front(2, 2);
+    bh.insert_front(2, 2);
+    uo.insert_front(std::numeric_limits<unsigned>::max(), 1);
+    uh.insert_front(std::numeric_limits<unsigned>::max(), 1);
+    assert(bo.find(2.5) != nullptr && bh.find(2.5) != nullptr);
+    assert(*as_const(bo).find(2.5) == 2 && bo.contains(2.5) == bh.contains(2.5));
+    assert(uo.contains(-1) == uh.contains(-1));
+    assert(uo.contains(-2) == uh.contains(-2) && !uo.contains(-2));
+  }
+  specialized_less_test<binder<Version, int>>();
+  specialized_less_test<binder<Version, int, cxx::persistent_storage>>();
+  specialized_less_test<binder<Version, int, cxx::small_storage<4>>>();
+
+  // Bez przezroczystej funkcji skrótu klucz trzeba zbudować.
+  static_assert(!reads_string_view<binder<string, int, cxx::hash_index<>>>);
+  binder<string, int, cxx::hash_index<>> bh;
+  bh.insert_front("a", 1);
+  bh.insert_after("a", "b", 2);
+  assert(bh.read("b") == 2);
+  bh.remove("a");
+  assert(bh.size() == 1);
+#endif
+
+// Testujemy operacje zgłaszające brak lub powtórzenie zakładki wynikiem.
+#if TEST_NUM == 716
+  {
+    Value v(1), w(2);
+    binder<Key, Value> b;
+    assert(b.try_remove() == cxx::binder_status::empty);
+    assert(b.try_remove(Key(1)) == cxx::binder_status::key_not_found);
+    assert(b.find(Key(1)) == nullptr);
+    assert(!b.contains(Key(1)));
+
+    assert(b.try_insert_front(Key(1), v) == cxx::binder_status::ok);
+    assert(b.try_insert_front(Key(1), w) == cxx::binder_status::key_exists);
+    assert(b.try_insert_after(Key(2), Key(3), w) == cxx::binder_status::key_not_found);
+    assert(b.try_insert_after(Key(1), Key(2), w) == cxx::binder_status::ok);
+    assert(b.try_insert_after(Key(1), Key(2), v) == cxx::binder_status::key_exists);
+    assert(b.size() == 2);
+    assert(b.contains(Key(2)));
+    assert(*as_const(b).find(Key(2)) == w);
+
+    // Nieudane operacje nie przestają współdzielić danych z kopią.
+    binder<Key, Value> copy(b);
+    size_t keys = Key::instance_count;
+    size_t values = Value::instance_count;
+    assert(b.try_insert_front(Key(2), v) == cxx::binder_status::key_exists);
+    assert(b.try_insert_after(Key(5), Key(6), v) == cxx::binder_status::key_not_found);
+    assert(b.try_remove(Key(5)) == cxx::binder_status::key_not_found);
+    assert(b.find(Key(5)) == nullptr);
+    assert(Key::instance_count == keys);
+    assert(Value::instance_count == values);
+
+    // find na modyfikowalnym skoroszycie działa jak read.
+    Value *p = b.find(Key(1));
+    assert(p && *p == v);
+    p->value = 2;
+    assert(*copy.find(Key(1)) == v);
+    binder<Key, Value> deep(b);
+    p->value = 1;
+    assert(*deep.find(Key(1)) == w);
+
+    assert(b.try_remove() == cxx::binder_status::ok);
+    assert(b.try_remove(Key(2)) == cxx::binder_status::ok);
+    assert(b.size() == 0);
+    assert(copy.size() == 2);
+
+    auto snapshot = copy.snapshot();
+    assert(snapshot.contains(Key(2)));
+    assert(snapshot.find(Key(3)) == nullptr);
+  }
+  assert(Key::instance_count == 0);
+  assert(Value::instance_count == 0);
+#endif
+
+// Testujemy dostęp do notatek według pozycji.
+#if TEST_NUM == 717
+  positional_test<binder<int, int, cxx::ranked_storage>>(1, 20000, 500);
+  positional_test<binder<int, int, cxx::ranked_storage, cxx::hash_index<>>>(2, 20000, 500);
+  positional_test<binder<int, int, cxx::ranked_storage, cxx::pool_allocator<>>>(3, 20000, 50);
+  static_assert(!positional<binder<int, int>>);
+
+  binder<string, int, cxx::ranked_storage> bs;
+  bs.insert_at(0, "b", 2);
+  bs.insert_at(0, "a", 1);
+  bs.insert_at(2, "c", 3);
+  assert(bs.index_of(string_view("c")) == 2);
+  auto snapshot = bs.snapshot();
+  bs.nth(0) = 10;
+  assert(snapshot.nth(0) == 1);
+  assert(snapshot.index_of("b") == 1);
+  assert(*snapshot.cnth(2) == 3);
+  assert(snapshot.cnth(3) == snapshot.cend());
+
+  auto throws = [](auto const &op) {
+    try {
+      op();
+    }
+    catch (invalid_argument const &) {
+      return true;
+    }
+    return false;
+  };
+  assert(throws([&] {as_const(bs).nth(3);}));
+  assert(throws([&] {bs.insert_at(4, "d", 4);}));
+  assert(throws([&] {bs.insert_at(1, "c", 4);}));
+  assert(throws([&] {bs.index_of("d");}));
+  assert(bs.size() == 3);
+
+  {
+    vector<Value> values;
+    for (size_t i = 0; i <= 20; i++) {
+      Value v(i);
+      values.push_back(v);
+    }
+
+    strong_operations_test<binder<Key, Value, cxx::ranked_storage>>(values);
+    strong_operations_test<binder<Key, Value, cxx::ranked_storage, cxx::hash_index<KeyHash>>>(values);
+  }
+  assert(Key::instance_count == 0);
+  assert(Value::instance_count == 0);
+#endif
+
+// Testujemy przechodzenie skoroszytów w obu kierunkach.
+#if TEST_NUM == 718
+  bidirectional_test<binder<int, int>>(100);
+  bidirectional_test<binder<int, int, cxx::hash_index<>>>(100);
+  bidirectional_test<binder<int, int, cxx::persistent_storage>>(100);
+  bidirectional_test<binder<int, int, cxx::ranked_storage>>(100);
+  bidirectional_test<binder<int, int, cxx::pool_allocator<>>>(100);
+#endif
+
+// Testujemy przestawianie notatek bez ich kopiowania.
+#if TEST_NUM == 719
+  move_test<binder<int, int>>(1, 20000, true);
+  move_test<binder<int, int, cxx::hash_index<>>>(2, 20000, true);
+  move_test<binder<int, int, cxx::ranked_storage>>(3, 20000, true);
+  move_test<binder<int, int, cxx::persistent_storage>>(4, 20000, false);
+
+  {
+    binder<Key, Value> b;
+    for (size_t i = 0; i < 10; i++)
+      b.insert_front(Key(i), Value(i));
+    size_t values = Value::instance_count;
+    size_t operations = Value::operation_count;
+    b.move_back(Key(9));
+    b.move_front(Key(0));
+    b.move_after(Key(5), Key(9));
+    assert(Value::instance_count == values);
+    assert(Value::operation_count == operations);
+    assert(*std::next(b.cbegin(), 5) == Value(9));
+  }
+  assert(Key::instance_count == 0);
+  assert(Value::instance_count == 0);
+#endif
+
+// Testujemy łączenie i dzielenie skoroszytów.
+#if TEST_NUM == 720
+  splice_test<binder<int, int>>(1, 5000, true);
+  splice_test<binder<int, int, cxx::hash_index<>>>(2, 5000, true);
+  splice_test<binder<int, int, cxx::ranked_storage>>(3, 5000, true);
+  splice_test<binder<int, int, cxx::persistent_storage>>(4, 5000, false);
+  splice_test<binder<int, int, cxx::pool_allocator<>>>(5, 5000, false);
+
+  {
+    binder<std::string, int> a, c;
+    a.insert_front("a", 1);
+    c.insert_front("c", 3);
+    a.splice_after(std::string_view("a"), std::move(c));
+    binder<std::string, int> t = a.split_after(std::string_view("a"));
+    assert(a.size() == 1 && t.read("c") == 3);
+  }
+
+  {
+    binder<Key, Value> a, c;
+    for (size_t i = 0; i < 10; i++)
+      a.insert_front(Key(i), Value(i));
+    c.insert_front(Key(20), Value(20));
+    a.splice_back(std::move(c));
+    binder<Key, Value> t = a.split_after(Key(5));
+    assert(a.size() == 5 && t.size() == 6);
+  }
+  assert(Key::instance_count == 0);
+  assert(Value::instance_count == 0);
+#endif
+
+// Testujemy puste skoroszyty bez alokacji.
+#if TEST_NUM == 721
+  empty_binder_test<binder<int, int>>();
+  empty_binder_test<binder<int, int, cxx::hash_index<>>>();
+  empty_binder_test<binder<int, int, cxx::persistent_storage>>();
+  empty_binder_test<binder<int, int, cxx::ranked_storage>>();
+  empty_binder_test<binder<int, int, cxx::pool_allocator<>>>();
+#endif
+
+// Testujemy małe skoroszyty trzymane w tablicach.
+#if TEST_NUM == 722
+  random_operations_test<binder<int, int, cxx::small_storage<>>>(1, 4000, 12);
+  random_operations_test<binder<int, int, cxx::small_storage<>>>(2, 4000, 300);
+  random_operations_test<binder<int, int, cxx::small_storage<4>, cxx::hash_index<>>>(3, 4000, 12);
+  random_operations_test<binder<int, int, cxx::small_storage<8, cxx::persistent_storage>>>(4, 4000, 12);
+  random_operations_test<binder<int, int, cxx::small_storage<1, cxx::ranked_storage>>>(5, 4000, 12);
+  positional_test<binder<int, int, cxx::small_storage<8, cxx::ranked_storage>>>(6, 4000, 12);
+  static_assert(!positional<binder<int, int, cxx::small_storage<>>>);
+
+  {
+    // Iteratory sprzed przeniesienia notatek do dużego magazynu wskazują
+    // te same notatki co iteratory wzięte po nim.
+    binder<int, int, cxx::small_storage<4>> b;
+    for (int i = 0; i < 4; i++)
+      b.insert_front(i, i);
+    auto first = b.cbegin(), second = std::next(first), end = b.cend();
+    b.insert_after(0, 4, 4);
+    assert(first == b.cbegin() && second == std::next(b.cbegin()) && end == b.cend());
+    assert(std::next(first) == second && std::next(first, 4) != end && std::next(first, 5) == end);
+  }
+
+  {
+    // Do ośmiu notatek skoroszyt zajmuje jedną alokację.
+    binder<int, int, cxx::small_storage<>> b;
+    allocation_count = 0;
+    for (int i = 0; i < 8; i++)
+      b.insert_front(i, i);
+    assert(allocation_count == 1);
+    b.insert_front(8, 8);
+    assert(allocation_count > 1 && b.size() == 9 && b.read(0) == 0);
+    b.clear();
+    allocation_count = 0;
+    b.insert_front(0, 0);
+    assert(allocation_count == 0);
+  }
+
+  {
+    // Wstawianie ciągu notatek, w trakcie którego skoroszyt przestaje być mały.
+    using B = binder<int, int, cxx::small_storage<>>;
+    B b, d;
+    for (int i = 0; i < 6; i++) {
+      b.insert_front(i, i);
+      d.insert_front(i, i);
+    }
+    pair<int, int> failing[] = {{10, 10}, {11, 11}, {12, 12}, {2, 2}};
+    bool catched = false;
+    try {
+      b.insert_range_after(3, std::begin(failing), std::end(failing));
+    }
+    catch (invalid_argument const &) {
+      catched = true;
+    }
+    assert(catched && b == d);
+
+    pair<int, int> batch[] = {{10, 10}, {11, 11}, {12, 12}, {13, 13}};
+    b.insert_range_after(3, std::begin(batch), std::end(batch));
+    vector<int> keys;
+    for (auto it = b.cbegin(); it != b.cend(); ++it)
+      keys.push_back(it.key());
+    assert((keys == vector<int>{5, 4, 3, 10, 11, 12, 13, 2, 1, 0}));
+
+    B tail = b.split_after(12);
+    b.splice_front(std::move(tail));
+    assert(b.size() == 10 && *b.cbegin() == 13);
+  }
+
+  {
+    binder<string, int, cxx::small_storage<>> b;
+    b.insert_front("b", 2);
+    b.insert_after(string_view("b"), "c", 3);
+    assert(b.read(string_view("c")) == 3 && b.contains("b"));
+  }
+
+  {
+    vector<Value> values;
+    for (size_t i = 0; i <= 20; i++) {
+      Value v(i);
+      values.push_back(v);
+    }
+
+    strong_operations_test<binder<Key, Value, cxx::small_storage<>>>(values);
+    strong_operations_test<binder<Key, Value, cxx::small_storage<64>>>(values);
+    strong_operations_test<binder<Key, Value, cxx::small_storage<8, cxx::persistent_storage>>>(values);
+    strong_operations_test<binder<Key, Value, cxx::small_storage<64>, cxx::hash_index<KeyHash>>>(values);
+  }
+  assert(Key::instance_count == 0);
+  assert(Value::instance_count == 0);
+#endif
+
+// Testujemy notatki w ciągłym wektorze.
+#if TEST_NUM == 723
+  random_operations_test<binder<int, int, cxx::flat_storage>>(1, 4000, 300);
+  random_operations_test<binder<int, int, cxx::flat_storage, cxx::hash_index<>>>(2, 4000, 300);
+  random_operations_test<binder<int, int, cxx::flat_storage, cxx::pool_allocator<>>>(3, 4000, 40);
+  layout_test<binder<int, int, cxx::flat_storage>>();
+  layout_test<binder<int, int, cxx::flat_storage, cxx::hash_index<>>>();
+
+  {
+    binder<string, string, cxx::flat_storage> b;
+    b.insert_front("b", "2");
+    b.insert_after(string_view("b"), "c", "3");
+    b.insert_front("a", "1");
+    b.remove(string_view("b"));
+    assert(b.read(string_view("c")) == "3" && b.size() == 2);
+  }
+
+  {
+    vector<Value> values;
+    for (size_t i = 0; i <= 20; i++) {
+      Value v(i);
+      values.push_back(v);
+    }
+
+    strong_operations_test<binder<Key, Value, cxx::flat_storage>>(values);
+    strong_operations_test<binder<Key, Value, cxx::flat_storage, cxx::hash_index<KeyHash>>>(values);
+  }
+  assert(Key::instance_count == 0);
+  assert(Value::instance_count == 0);
+#endif
+// Testujemy notatki w listach bloków.
+#if TEST_NUM == 724
+  random_operations_test<binder<int, int, cxx::unrolled_storage<>>>(1, 4000, 300);
+  random_operations_test<binder<int, int, cxx::unrolled_storage<4>>>(2, 4000, 300);
+  random_operations_test<binder<int, int, cxx::unrolled_storage<2>, cxx::hash_index<>>>(3, 4000, 100);
+  random_operations_test<binder<int, int, cxx::unrolled_storage<5>, cxx::pool_allocator<>>>(4, 4000, 40);
+
+  {
+    // Notatki dopisywane na koniec wypełniają kolejne bloki po 8.
+    binder<int, int, cxx::unrolled_storage<8>> b;
+    b.insert_front(0, 0);
+    for (int i = 1; i < 64; i++)
+      b.insert_after(i - 1, i, i);
+    auto it = b.cbegin();
+    for (int i = 0; i < 64; i++, it++)
+      assert(i % 8 == 0 || &*it == &*std::prev(it) + 1);
+
+    // Wstawienie w środek pełnego bloku dzieli go; notatki zostają w kolejności.
+    b.insert_after(3, 100, 100);
+    b.insert_after(100, 101, 101);
+    b.remove(60);
+    b.move_front(40);
+    int expected[] = {40, 0, 1, 2, 3, 100, 101, 4};
+    assert(std::equal(std::begin(expected), std::end(expected), b.cbegin()));
+    assert(b.size() == 65 && b.read(63) == 63);
+  }
+
+  {
+    // Po rzadkim usuwaniu bloki nadal są zapełnione co najmniej w ćwierci.
+    // Sąsiednie notatki z różnych bloków dzieli co najmniej rozmiar bloku.
+    using B = binder<int, int, cxx::unrolled_storage<32>>;
+    auto chunks = [](B const &b) {
+      size_t count = b.size() > 0;
+      for (auto it = b.cbegin(); it != b.cend() && std::next(it) != b.cend(); it++)
+        count += std::abs(&*std::next(it) - &*it) >= 32;
+      return count;
+    };
+
+    B b;
+    b.insert_front(0, 0);
+    for (int i = 1; i < 32000; i++)
+      b.insert_after(i - 1, i, i);
+    assert(chunks(b) == 1000);
+    B back = b;
+    for (int i = 0; i < 32000; i++)
+      if (i % 32 != 0)
+        b.remove(i);
+    for (int i = 31999; i >= 0; i--)
+      if (i % 32 != 0)
+        back.remove(i);
+    assert(b.size() == 1000 && back.size() == 1000);
+    assert(chunks(b) <= 1000 / 8 + 1 && chunks(back) <= 1000 / 8 + 1);
+    for (int i = 0; i < 1000; i++)
+      assert(b.read(i * 32) == i * 32 && back.read(i * 32) == i * 32);
+  }
+
+  {
+    binder<string, string, cxx::unrolled_storage<>> b;
+    b.insert_front("b", "2");
+    b.insert_after(string_view("b"), "c", "3");
+    b.insert_front("a", "1");
+    b.remove(string_view("b"));
+    assert(b.read(string_view("c")) == "3" && b.size() == 2);
+  }
+
+  {
+    vector<Value> values;
+    for (size_t i = 0; i <= 20; i++) {
+      Value v(i);
+      values.push_back(v);
+    }
+
+    strong_operations_test<binder<Key, Value, cxx::unrolled_storage<4>>>(values);
+    strong_operations_test<binder<Key, Value, cxx::unrolled_storage<2>, cxx::hash_index<KeyHash>>>(values);
+  }
+  assert(Key::instance_count == 0);
+  assert(Value::instance_count == 0);
+#endif
+// Testujemy skoroszyt z zakładkami, notatkami i kolejnością w osobnych wektorach.
+#if TEST_NUM == 725
+  random_operations_test<binder<int, int, cxx::soa_storage>>(1, 4000, 300);
+  random_operations_test<binder<int, int, cxx::soa_storage, cxx::pool_allocator<>>>(2, 4000, 40);
+
+  {
+    // Zakładki każdego rozmiaru, znalezione w każdym miejscu bloku porównań,
+    // także gdy usunięta notatka z tą samą zakładką leży wcześniej.
+    auto keys_test = [](auto key) {
+      using K = decltype(key);
+      binder<K, int, cxx::soa_storage> b;
+      for (int i = 0; i < 100; i++)
+        b.insert_front(K(i), i);
+      for (int i = 0; i < 100; i++)
+        assert(b.read(K(i)) == i);
+      assert(b.find(K(100)) == nullptr);
+      b.remove(K(40));
+      b.insert_front(K(120), 120);
+      b.insert_front(K(40), -40);
+      assert(b.read(K(40)) == -40 && b.size() == 101);
+      assert(*b.cbegin() == -40 && *std::next(b.cbegin(), 2) == 99);
+    };
+    keys_test(char(0));
+    keys_test(short(0));
+    keys_test(0u);
+    keys_test(0LL);
+    keys_test(0.0);
+  }
+
+  {
+    vector<Value> values;
+    for (size_t i = 0; i <= 20; i++) {
+      Value v(i);
+      values.push_back(v);
+    }
+
+    strong_operations_test<binder<int, Value, cxx::soa_storage>, int>(values);
+  }
+  assert(Value::instance_count == 0);
+#endif
+// Testujemy indeks wybierany domyślnie na podstawie typu zakładek.
+#if TEST_NUM == 726
+  static_assert(std::is_same_v<cxx::default_index_t<char>, cxx::hash_index<>>);
+  static_assert(std::is_same_v<cxx::default_index_t<std::uint8_t>, cxx::hash_index<>>);
+  static_assert(std::is_same_v<cxx::default_index_t<bool>, cxx::hash_index<>>);
+  static_assert(std::is_same_v<cxx::default_index_t<int>, cxx::hash_index<>>);
+  static_assert(std::is_same_v<cxx::default_index_t<string>,
+                               cxx::hash_index<cxx::detail::string_hash, std::equal_to<>>>);
+  static_assert(std::is_same_v<cxx::default_index_t<double>, cxx::ordered_index<>>);
+  static_assert(std::is_same_v<cxx::default_index_t<Key>, cxx::ordered_index<>>);
+
+  random_operations_test<binder<short, int, cxx::direct_index>>(1, 4000, 300);
+  random_operations_test<binder<short, int, cxx::direct_index, cxx::pool_allocator<>>>(2, 4000, 40);
+  random_operations_test<binder<short, int, cxx::ranked_storage, cxx::direct_index>>(3, 4000, 300);
+  random_operations_test<binder<int, int, cxx::ordered_index<>>>(4, 4000, 300);
+
+  {
+    // Wszystkie 256 zakładek jednobajtowych, także ujemne.
+    using B = binder<signed char, int, cxx::direct_index>;
+    B b;
+    b.insert_front(-128, -128);
+    for (int i = -127; i < 128; i++)
+      b.insert_after(static_cast<signed char>(i - 1), static_cast<signed char>(i), i);
+    assert(b.size() == 256);
+    for (int i = -128; i < 128; i++)
+      assert(b.read(static_cast<signed char>(i)) == i);
+    assert(b.try_insert_front(5, 0) == cxx::binder_status::key_exists);
+    b.remove(-1);
+    assert(!b.contains(-1) && b.contains(0) && b.size() == 255);
+
+    B copy(b);
+    b.insert_front(-1, 1);
+    b.move_back(-128);
+    assert(copy.size() == 255 && *copy.cbegin() == -128 && *b.cbegin() == 1);
+
+    B tail = b.split_after(0);
+    b.splice_back(std::move(tail));
+    assert(b.size() == 256 && tail.size() == 0);
+  }
+
+  {
+    // Domyślny indeks zakładek std::string szuka po string_view bez budowania
+    // napisu.
+    binder<string, int> b;
+    b.insert_front("a", 1);
+    b.insert_after(string_view("a"), "b", 2);
+    allocation_count = 0;
+    assert(b.contains(string_view("b")) && as_const(b).read(string_view("a")) == 1);
+    assert(allocation_count == 0);
+  }
+
+  {
+    vector<Value> values;
+    for (size_t i = 0; i <= 20; i++) {
+      Value v(i);
+      values.push_back(v);
+    }
+
+    strong_operations_test<binder<short, Value, cxx::direct_index>, short>(values);
+    strong_operations_test<binder<int, Value>, int>(values);
+  }
+  assert(Value::instance_count == 0);
+#endif
+// Testujemy kopiowanie danych skoroszytu z trywialnie kopiowalnymi notatkami
+// w całości, razem z tablicą zakładek i usuniętymi notatkami.
+#if TEST_NUM == 727
+  {
+    binder<int, int, cxx::soa_storage> b;
+    b.insert_front(0, 0);
+    for (int i = 1; i < 10000; i++)
+      b.insert_after(i - 1, i, i);
+    for (int i = 0; i < 10000; i += 3)
+      b.remove(i);
+    b.move_front(5000);
+
+    binder<int, int, cxx::soa_storage> copy(b);
+    size_t allocations = allocation_count;
+    copy.read(1) = -1;
+    // Dane skoroszytu i cztery wektory.
+    assert(allocation_count - allocations == 5);
+
+    assert(b.read(1) == 1 && copy.read(1) == -1);
+    copy.read(1) = 1;
+    assert(copy == b && *copy.cbegin() == 5000);
+    assert(!copy.contains(3) && copy.contains(4));
+
+    // Kopia dalej działa: wstawianie aż do przebudowy, usuwanie i wyszukiwanie.
+    for (int i = 10000; i < 30000; i++)
+      copy.insert_front(i, i);
+    for (int i = 1; i < 10000; i += 3)
+      copy.remove(i);
+    assert(copy.size() == b.size() + 20000 - 3333);
+    assert(copy.read(29999) == 29999 && copy.read(2) == 2 && !copy.contains(1));
+    assert(b.size() == 6666 && b.read(9998) == 9998);
+  }
+
+  random_operations_test<binder<long long, double, cxx::soa_storage>>(1, 4000, 300);
+  random_operations_test<binder<short, int, cxx::soa_storage, cxx::pool_allocator<>>>(2, 4000, 300);
+#endif
+// Testujemy kopiowanie indeksu zakładek bez porównywania i haszowania zakładek.
+#if TEST_NUM == 728
+  {
+    static size_t calls = 0;
+    struct counting_less {
+      bool operator()(int a, int b) const {
+        ++calls;
+        return a < b;
+      }
+    };
+    struct counting_hash {
+      size_t operator()(int a) const {
+        ++calls;
+        return std::hash<int>{}(a);
+      }
+    };
+    struct counting_equal {
+      bool operator()(int a, int b) const {
+        ++calls;
+        return a == b;
+      }
+    };
+
+    auto clone_test = [&](auto b) {
+      using B = decltype(b);
+      for (int i = 0; i < 5000; i++)
+        b.insert_front(static_cast<int>(static_cast<unsigned>(i) * 2654435761u % 100000), i);
+      b.move_back(static_cast<int>(2654435761u % 100000));
+
+      B copy(b);
+      calls = 0;
+      copy.insert_front(-1, -1);
+      // Ponowne wstawienie 5000 zakładek wymagałoby tysięcy wywołań.
+      assert(calls < 100);
+
+      assert(copy.size() == b.size() + 1);
+      assert(std::equal(b.cbegin(), b.cend(), std::next(copy.cbegin())));
+      copy.remove(-1);
+      assert(copy == b);
+    };
+    clone_test(binder<int, int, cxx::ordered_index<counting_less>>());
+    clone_test(binder<int, int, cxx::hash_index<counting_hash, counting_equal>>());
+    clone_test(binder<int, int, cxx::ranked_storage, cxx::ordered_index<counting_less>>());
+    clone_test(binder<int, int, cxx::ranked_storage, cxx::hash_index<counting_hash, counting_equal>>());
+  }
+
+  {
+    binder<char, int> b;
+    for (int i = 0; i < 100; i++)
+      b.insert_front(static_cast<char>(i), i);
+    binder<char, int> copy(b);
+    copy.read(5) = -5;
+    assert(b.read(5) == 5 && copy.read(5) == -5 && copy.size() == 100);
+    auto const& c = copy;
+    for (int i = 0; i < 100; i++)
+      assert(i == 5 || c.read(static_cast<char>(i)) == i);
+  }
+
+  {
+    // Kopia drzewa pozycji zachowuje pozycje notatek.
+    binder<int, int, cxx::ranked_storage> b;
+    for (int i = 0; i < 1000; i++)
+      b.insert_front(i, i);
+    binder<int, int, cxx::ranked_storage> copy(b);
+    copy.insert_front(-1, -1);
+    for (int i = 0; i < 1000; i += 37)
+      assert(copy.nth(i + 1) == 999 - i && b.nth(i) == 999 - i);
+  }
+#endif
+// Testujemy współdzielenie wartości notatek między kopiami skoroszytu.
+#if TEST_NUM == 729
+  {
+    using B = binder<int, vector<int>, cxx::shared_values<>>;
+    B b;
+    for (int i = 0; i < 1000; i++)
+      b.insert_front(i, vector<int>(1000, i));
+
+    B copy(b);
+    size_t allocations = allocation_count;
+    copy.read(1)[0] = -1;
+    // Dane skoroszytu, 1000 notatek, tymczasowa mapa węzłów, kopia jednej
+    // wartości i jej wektor. Pozostałe wartości nie są kopiowane.
+    assert(allocation_count - allocations == 1004);
+    assert(b.read(1)[0] == 1 && copy.read(1)[0] == -1);
+
+    B const &cb = b, &ccopy = copy;
+    assert(&cb.read(2) == &ccopy.read(2) && &cb.read(1) != &ccopy.read(1));
+
+    // Kopia po wydaniu referencji kopiuje tylko wydaną wartość.
+    vector<int> &r = copy.read(3);
+    allocations = allocation_count;
+    B deep(copy);
+    assert(allocation_count - allocations == 1002 + 2 * 2);
+    r[0] = -3;
+    assert(deep.read(3)[0] == 3 && ccopy.read(3)[0] == -3 && cb.read(3)[0] == 3);
+    B const &cdeep = deep;
+    assert(&cdeep.read(2) == &cb.read(2) && &cdeep.read(1) != &ccopy.read(1));
+    assert(cdeep.read(1)[0] == -1);
+
+    // Wartość współdzielona z b jest kopiowana raz, potem modyfikowana w miejscu.
+    allocations = allocation_count;
+    deep.read(500)[0] = -500;
+    vector<int> const *v = &cdeep.read(500);
+    deep.read(500)[1] = -500;
+    assert(&cdeep.read(500) == v && allocation_count - allocations == 2);
+    assert(cb.read(500)[0] == 500 && cb.read(500)[1] == 500);
+  }
+
+  {
+    using B = binder<int, int, cxx::shared_values<cxx::ranked_storage>>;
+    B b;
+    for (int i = 0; i < 100; i++)
+      b.insert_front(i, i);
+    B copy(b);
+    copy.nth(10) = -1;
+    assert(b.nth(10) == 89 && copy.nth(10) == -1 && copy.index_of(89) == 10);
+  }
+
+  random_operations_test<binder<int, int, cxx::shared_values<>>>(1, 4000, 300);
+  random_operations_test<binder<int, int, cxx::shared_values<cxx::ranked_storage>>>(2, 4000, 300);
+  random_operations_test<binder<int, int, cxx::shared_values<cxx::flat_storage>, cxx::hash_index<>>>(3, 4000, 300);
+  random_operations_test<binder<int, int, cxx::shared_values<cxx::soa_storage>, cxx::single_threaded>>(4, 4000, 300);
+
+  vector<Value> values;
+  for (size_t i = 0; i <= 20; i++) {
+    Value v(i);
+    values.push_back(v);
+  }
+
+  strong_operations_test<binder<Key, Value, cxx::shared_values<>>>(values);
+  strong_operations_test<binder<Key, Value, cxx::shared_values<cxx::unrolled_storage<4>>>>(values);
+#endif
 }
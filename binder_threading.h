@@ -0,0 +1,21 @@
+#ifndef BINDER_THREADING_H
+#define BINDER_THREADING_H
+
+#include "binder_detail.h"
+
+namespace cxx {
+    // Threading policies. They choose the reference counter of the storage
+    // shared between copies of a binder.
+
+    // Copies of a binder may be used by different threads (default).
+    struct multi_threaded : detail::threading_policy {
+        using counter = detail::atomic_count;
+    };
+
+    // All copies of a binder stay on one thread; the counter is not atomic.
+    struct single_threaded : detail::threading_policy {
+        using counter = detail::plain_count;
+    };
+}
+
+#endif //BINDER_THREADING_H
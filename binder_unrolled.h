@@ -0,0 +1,403 @@
+#ifndef BINDER_UNROLLED_H
+#define BINDER_UNROLLED_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "binder_allocator.h"
+#include "binder_detail.h"
+#include "binder_flat.h"
+#include "binder_index.h"
+
+namespace cxx {
+    // Storage with the values in a doubly-linked list of chunks of up to C
+    // notes. Within a chunk a note keeps its slot; a byte array lists the
+    // slots in the order of the notes, so inserting in the middle of a chunk
+    // shifts bytes, not values. A full chunk is split at the insertion point,
+    // and a chunk left with at most a quarter of its notes after an erase
+    // takes notes of a neighbour (if values move without throwing); erasing
+    // keeps the handle of the note before the erased one. Appending fills
+    // chunks completely, so a scan reads mostly contiguous memory. The key
+    // index policy finds the chunk and slot of a key; its nodes hold the
+    // keys. Unsharing copies every note.
+    template <size_t C = 32>
+    struct unrolled_storage : detail::storage_policy {
+        template <typename K, typename V, typename Policies>
+        class data {
+            static_assert(C >= 2 && C < 256, "unrolled_storage chunks hold 2 to 255 notes");
+
+            using index_policy = detail::select_policy_t<detail::index_policy, default_index_t<K>, Policies>;
+            using allocator_policy = detail::select_policy_t<detail::allocator_policy, default_allocator, Policies>;
+            using allocator_type = typename allocator_policy::allocator_type;
+            using link = std::uint8_t;
+
+            struct chunk;
+
+        public:
+            struct handle {
+                chunk* c = nullptr;
+                link slot = 0;
+
+                friend bool operator==(handle const&, handle const&) = default;
+            };
+
+        private:
+            using iters_map = typename index_policy::template index<K, handle, allocator_type, detail::flat_body>;
+            using node = typename iters_map::node;
+
+            // order lists the used slots in the order of the notes, then the
+            // free ones; rank[s] is the position of the used slot s in order.
+            struct chunk {
+                chunk* prev = nullptr;
+                chunk* next = nullptr;
+                link size = 0;
+                link order[C];
+                link rank[C];
+                node* nodes[C];
+                alignas(V) std::byte values[C * sizeof(V)];
+
+                chunk() noexcept {
+                    for (size_t i = 0; i < C; i++)
+                        order[i] = rank[i] = static_cast<link>(i);
+                }
+
+                void* raw(link s) noexcept { return values + s * sizeof(V); }
+
+                V& value(link s) noexcept { return *std::launder(reinterpret_cast<V*>(raw(s))); }
+
+                V const& value(link s) const noexcept {
+                    return *std::launder(reinterpret_cast<V const*>(values + s * sizeof(V)));
+                }
+            };
+
+            using chunk_alloc = typename std::allocator_traits<allocator_type>::template rebind_alloc<chunk>;
+            using chunk_traits = std::allocator_traits<chunk_alloc>;
+
+            static constexpr bool nothrow_relocation = std::is_nothrow_move_constructible_v<V>;
+
+            typename allocator_policy::arena arena;
+            iters_map iters{arena.get()};
+            [[no_unique_address]] chunk_alloc alloc{arena.get()};
+            chunk* head = nullptr;
+            chunk* tail = nullptr;
+            size_t count = 0;
+
+            static handle& locator(node* n) noexcept { return iters_map::body(n).slot; }
+
+            // A new empty chunk linked after c, or at the front if c is null.
+            chunk* make_chunk(chunk* c) {                                      // strong guarantee
+                chunk* d = chunk_traits::allocate(alloc, 1);
+                chunk_traits::construct(alloc, d);
+                d->prev = c;
+                d->next = c ? c->next : head;
+                (d->next ? d->next->prev : tail) = d;
+                (c ? c->next : head) = d;
+                return d;
+            }
+
+            // Unlinks and frees c, whose values must have been destroyed.
+            void drop_chunk(chunk* c) noexcept {
+                (c->prev ? c->prev->next : head) = c->next;
+                (c->next ? c->next->prev : tail) = c->prev;
+                chunk_traits::destroy(alloc, c);
+                chunk_traits::deallocate(alloc, c, 1);
+            }
+
+            // Gives the free slot at order[c->size] position i in the order.
+            static void take_slot(chunk* c, link i) noexcept {
+                link s = c->order[c->size];
+                for (link j = c->size; j > i; j--) {
+                    c->order[j] = c->order[j - 1];
+                    c->rank[c->order[j]] = j;
+                }
+                c->order[i] = s;
+                c->rank[s] = i;
+                ++c->size;
+            }
+
+            // Moves the slot at position i of the order to the free ones.
+            static void release_slot(chunk* c, link i) noexcept {
+                link s = c->order[i];
+                for (link j = i; j + 1 < c->size; j++) {
+                    c->order[j] = c->order[j + 1];
+                    c->rank[c->order[j]] = j;
+                }
+                --c->size;
+                c->order[c->size] = s;
+            }
+
+            // Moves the notes at positions [first, last) of the order of from
+            // to position at of the order of to, which has room for them.
+            // Values are moved if that cannot throw and copied otherwise; the
+            // notes that stay keep their slots.
+            void relocate(chunk* from, link first, link last, chunk* to, link at) { // strong guarantee
+                link n = last - first;
+                link built = 0;
+                try {
+                    for (; built < n; built++)
+                        ::new (to->raw(to->order[to->size + built]))
+                            V(std::move_if_noexcept(from->value(from->order[first + built])));
+                } catch (...) {
+                    for (link j = 0; j < built; j++)
+                        to->value(to->order[to->size + j]).~V();
+                    throw;
+                }
+
+                link slots[C];                                                  // no-throw from here
+                for (link j = 0; j < n; j++)
+                    slots[j] = to->order[to->size + j];
+                for (link j = to->size; j > at; j--) {
+                    to->order[j - 1 + n] = to->order[j - 1];
+                    to->rank[to->order[j - 1 + n]] = j - 1 + n;
+                }
+                for (link j = 0; j < n; j++) {
+                    link s = from->order[first + j];
+                    link t = slots[j];
+                    to->order[at + j] = t;
+                    to->rank[t] = at + j;
+                    to->nodes[t] = from->nodes[s];
+                    locator(from->nodes[s]) = {to, t};
+                    from->value(s).~V();
+                    slots[j] = s;
+                }
+                to->size += n;
+
+                for (link j = last; j < from->size; j++) {
+                    from->order[j - n] = from->order[j];
+                    from->rank[from->order[j - n]] = j - n;
+                }
+                from->size -= n;
+                for (link j = 0; j < n; j++)
+                    from->order[from->size + j] = slots[j];
+            }
+
+            // Refills c, which holds at most a quarter of a chunk, with notes
+            // of a neighbour: the whole neighbour if they fit together in a
+            // chunk, or else half the difference of their sizes. Only notes
+            // of the neighbour move. Notes are taken from prev only if the
+            // erased note was not the first of c (at position i), so the note
+            // before the erased one keeps its handle.
+            void refill(chunk* c, link i) noexcept {
+                chunk* d = c->next;
+                chunk* p = i > 0 ? c->prev : nullptr;
+                if (d && c->size + d->size <= C) {
+                    relocate(d, 0, d->size, c, c->size);
+                    drop_chunk(d);
+                } else if (p && c->size + p->size <= C) {
+                    relocate(p, 0, p->size, c, 0);
+                    drop_chunk(p);
+                } else if (d && (!p || d->size >= p->size)) {
+                    relocate(d, 0, static_cast<link>((d->size - c->size) / 2), c, c->size);
+                } else if (p) {
+                    relocate(p, static_cast<link>(p->size - (p->size - c->size) / 2), p->size, c, 0);
+                }
+            }
+
+            // A chunk with room for a note after position (at the front if
+            // position is end()) and the note's position in its order. A full
+            // chunk is split at that position, so position and the notes
+            // before it stay where they are.
+            std::pair<chunk*, link> room_after(handle position) {              // strong guarantee
+                chunk* c = position.c ? position.c : head;
+                if (!c)
+                    return {make_chunk(nullptr), 0};
+
+                link i = position.c ? static_cast<link>(c->rank[position.slot] + 1) : 0;
+                if (c->size < C)
+                    return {c, i};
+                if (i == C)
+                    return {c->next && c->next->size < C ? c->next : make_chunk(c), 0};
+
+                chunk* d = make_chunk(c);
+                try {
+                    relocate(c, i, c->size, d, 0);
+                } catch (...) {
+                    drop_chunk(d);
+                    throw;
+                }
+                return {c, i};
+            }
+
+            // Builds the value of the note of node n after position.
+            template <typename VT>
+            handle place(handle position, node* n, VT&& value_args) {           // strong guarantee
+                auto [c, i] = room_after(position);
+                link s = c->order[c->size];
+                try {
+                    std::apply([&](auto&&... args) { ::new (c->raw(s)) V(std::forward<decltype(args)>(args)...); },
+                               std::forward<VT>(value_args));
+                } catch (...) {
+                    if (c->size == 0)
+                        drop_chunk(c);
+                    throw;
+                }
+
+                take_slot(c, i);
+                c->nodes[s] = n;
+                locator(n) = {c, s};
+                ++count;
+                return {c, s};
+            }
+
+            // Inserts a note after position; make() adds the key to the index
+            // and returns its node, or null if the key is present (then end()
+            // is returned).
+            template <typename Make, typename VT>
+            handle add(handle position, Make const& make, VT&& value_args) {
+                node* n = make();                                               // strong guarantee
+                if (!n)
+                    return end();
+
+                try {
+                    return place(position, n, std::forward<VT>(value_args));    // strong guarantee
+                } catch (...) {
+                    iters.erase(n);
+                    throw;
+                }
+            }
+
+            // Destroys the value of h and frees its slot, keeping its node.
+            void remove_slot(handle h) noexcept {
+                chunk* c = h.c;
+                link i = c->rank[h.slot];
+                c->value(h.slot).~V();
+                release_slot(c, i);
+                --count;
+
+                if (c->size == 0) {
+                    drop_chunk(c);
+                } else if constexpr (nothrow_relocation) {
+                    if (c->size <= C / 4)
+                        refill(c, i);
+                }
+            }
+
+            void destroy_all() noexcept {
+                while (head) {
+                    for (link i = 0; i < head->size; i++)
+                        head->value(head->order[i]).~V();
+                    drop_chunk(head);
+                }
+                count = 0;
+            }
+
+        public:
+            template <typename Q>
+            static constexpr bool transparent_for = index_policy::template transparent_for<K, Q>;
+
+            data() = default;
+
+            data(data const& other) : data() {
+                iters.reserve(other.count);
+                for (handle h = other.begin(); h != other.end(); h = other.next(h))
+                    add(last(), [&] { return iters.emplace(other.key(h), handle()); },
+                        std::forward_as_tuple(other.value(h)));
+            }
+
+            data(data const& other, detail::deep_copy_t) : data(other) {}
+
+            ~data() {
+                destroy_all();
+            }
+
+            size_t size() const noexcept { return count; }
+
+            handle begin() const noexcept { return head ? handle{head, head->order[0]} : handle(); }
+            handle last() const noexcept { return tail ? handle{tail, tail->order[tail->size - 1]} : handle(); }
+            handle end() const noexcept { return {}; }
+
+            handle next(handle h) const noexcept {
+                link i = h.c->rank[h.slot];
+                if (i + 1 < h.c->size)
+                    return {h.c, h.c->order[i + 1]};
+                chunk* c = h.c->next;
+                return c ? handle{c, c->order[0]} : handle();
+            }
+
+            handle prev(handle h) const noexcept {
+                link i = h.c->rank[h.slot];
+                if (i > 0)
+                    return {h.c, h.c->order[i - 1]};
+                chunk* c = h.c->prev;
+                return c ? handle{c, c->order[c->size - 1]} : handle();
+            }
+
+            template <typename Q>
+            handle find(Q const& k) const {
+                node* n = iters.find(k);
+                return n ? iters_map::body(n).slot : handle();
+            }
+
+            K const& key(handle h) const noexcept { return iters_map::key_of(h.c->nodes[h.slot]); }
+
+            V const& value(handle h) const noexcept { return h.c->value(h.slot); }
+
+            V& value_for_write(handle h) noexcept { return h.c->value(h.slot); }
+
+            template <typename KK, typename VV>
+            handle insert_front(KK&& k, VV&& v) {
+                return insert_after(end(), std::forward<KK>(k), std::forward<VV>(v));
+            }
+
+            template <typename KK, typename VV>
+            handle insert_after(handle position, KK&& k, VV&& v) {
+                return add(position, [&] { return iters.emplace(std::forward<KK>(k), handle()); },
+                           std::forward_as_tuple(std::forward<VV>(v)));
+            }
+
+            // Inserts at the back; returns end() if k is already present.
+            template <typename KK, typename VV>
+            handle try_append(KK&& k, VV&& v) {
+                return add(last(), [&] { return iters.try_emplace_back(std::forward<KK>(k), handle()); },
+                           std::forward_as_tuple(std::forward<VV>(v)));
+            }
+
+            // Builds the key and the value from the elements of the tuples and
+            // inserts the note after position, or at the front if position is
+            // end(). Returns end() if the key is already present.
+            template <typename KT, typename VT>
+            handle try_emplace_after(handle position, KT&& key_args, VT&& value_args) {
+                return add(position,
+                           [&] {
+                               return iters.try_emplace_piecewise(std::forward<KT>(key_args),
+                                                                  std::forward_as_tuple(handle()));
+                           },
+                           std::forward<VT>(value_args));
+            }
+
+            // Moves the note h after position, or to the front if position is
+            // end(). Within a chunk only the order changes; otherwise the value
+            // is moved (or copied, if moving may throw) to its new chunk.
+            void relink_after(handle position, handle h) {
+                chunk* c = h.c;
+                if ((position.c ? position.c : head) == c) {
+                    release_slot(c, c->rank[h.slot]);
+                    take_slot(c, position.c ? static_cast<link>(c->rank[position.slot] + 1) : 0);
+                    return;
+                }
+
+                place(position, c->nodes[h.slot],                               // strong guarantee
+                      std::forward_as_tuple(std::move_if_noexcept(c->value(h.slot))));
+                remove_slot(h);
+            }
+
+            void erase(handle position) noexcept {
+                node* n = position.c->nodes[position.slot];
+                remove_slot(position);
+                iters.erase(n);
+            }
+
+            void clear() noexcept {
+                destroy_all();
+                iters.clear();
+            }
+        };
+    };
+}
+
+#endif //BINDER_UNROLLED_H
@@ -18,6 +18,7 @@ add_range_to_args_compile 301 306
 add_range_to_args_compile 401 407
 add_range_to_args_compile 501 513
 add_range_to_args_compile 601 604
+add_range_to_args_compile 701 729
 
 #args_nocompile=()
 